@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+
+// Статический файл веб-клиента, целиком лежащий в памяти.
+struct Asset {
+    std::string contentType;
+    std::string body;
+    // пусто, если zlib нет или сжатие не уменьшает файл
+    std::string gzipBody;
+    // сильные ETag по содержимому, у сжатого варианта свой
+    std::string etag;
+    std::string gzipEtag;
+};
+
+// Файлы каталога web читаются и сжимаются один раз при старте сервера,
+// дальше запросы обслуживаются из памяти без обращений к диску.
+class AssetCache {
+private:
+    std::unordered_map<std::string, Asset> assets;
+
+    static std::string contentTypeFor(const std::filesystem::path& path);
+
+public:
+    // загружает файлы из root под адресами "/<имя>", index.html доступен и как "/";
+    // возвращает число загруженных файлов
+    size_t load(const std::filesystem::path& root);
+    // nullptr, если такого файла нет
+    const Asset* find(const std::string& url) const;
+};
@@ -0,0 +1,138 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+enum class CellState : uint8_t {
+    EMPTY,
+    SHIP,
+    HIT,
+    MISS,
+    KILL
+};
+
+// Поле хранится битовыми плоскостями (ship / hit / miss / kill).
+// SHIP = ship, HIT = ship|hit, KILL = ship|hit|kill, MISS = miss.
+// Небольшие поля плотные: строка за строкой, по 64 клетки в слове. Поля больше
+// DENSE_LIMIT клеток разреженные: плитки 8x8 (одно слово на плоскость) заводятся
+// при первой записи, номера кораблей лежат в хеш-таблице.
+class Board {
+private:
+    enum Plane : uint8_t {
+        SHIP_PLANE,
+        HIT_PLANE,
+        MISS_PLANE,
+        KILL_PLANE,
+        PLANE_COUNT
+    };
+
+    struct Tile {
+        uint64_t planes[PLANE_COUNT] = {0, 0, 0, 0};
+    };
+
+    struct CellKey {
+        uint64_t x;
+        uint64_t y;
+        bool operator==(const CellKey& other) const { return x == other.x && y == other.y; }
+    };
+
+    struct CellKeyHash {
+        size_t operator()(const CellKey& key) const {
+            return static_cast<size_t>(key.x * 0x9E3779B97F4A7C15ULL ^ (key.y + 0x632BE59BD9B4E019ULL));
+        }
+    };
+
+    uint64_t width;
+    uint64_t height;
+    bool sparse;
+    uint64_t wordsPerRow;
+    uint64_t planeWords;
+    uint64_t tailMask;
+    std::vector<uint64_t> bits;
+    // номер корабля в клетке (индекс во флоте + 1), 0 - пусто
+    std::vector<uint16_t> shipIds;
+    std::unordered_map<CellKey, Tile, CellKeyHash> tiles;
+    std::unordered_map<CellKey, uint16_t, CellKeyHash> sparseShipIds;
+
+    static CellState decode(const uint64_t* planes, uint64_t stride, uint64_t word, uint64_t bit);
+    static uint64_t stateMask(const uint64_t* planes, uint64_t stride, uint64_t word, CellState state);
+    static void setMask(uint64_t* planes, uint64_t stride, uint64_t word, uint64_t mask, CellState state);
+    uint64_t stateWord(uint64_t word, CellState state) const;
+    void setWord(uint64_t word, uint64_t mask, CellState state) { setMask(bits.data(), planeWords, word, mask, state); }
+    bool clipRect(uint64_t& x0, uint64_t& y0, uint64_t& x1, uint64_t& y1) const;
+    static uint64_t rangeMask(uint64_t from, uint64_t to);
+    CellState getSparse(uint64_t x, uint64_t y) const;
+    void setSparse(uint64_t x, uint64_t y, CellState state);
+
+public:
+    // 2^20 клеток: две плотные доски с номерами кораблей занимают около 5 МБ
+    static const uint64_t DENSE_LIMIT = uint64_t(1) << 20;
+
+    Board();
+    Board(uint64_t w, uint64_t h);
+
+    void reset(uint64_t w, uint64_t h);
+    void clear();
+    uint64_t getWidth() const { return width; }
+    uint64_t getHeight() const { return height; }
+    bool empty() const { return width == 0 || height == 0; }
+    bool isSparse() const { return sparse; }
+    static bool fitsDense(uint64_t w, uint64_t h) { return h == 0 || w <= DENSE_LIMIT / h; }
+
+    CellState get(uint64_t x, uint64_t y) const {
+        if (sparse) return getSparse(x, y);
+        return decode(bits.data(), planeWords, y * wordsPerRow + (x >> 6), x & 63);
+    }
+
+    void set(uint64_t x, uint64_t y, CellState state) {
+        if (sparse) return setSparse(x, y, state);
+        setWord(y * wordsPerRow + (x >> 6), uint64_t(1) << (x & 63), state);
+    }
+
+    uint16_t getShipId(uint64_t x, uint64_t y) const;
+    void setShipId(uint64_t x, uint64_t y, uint16_t id);
+
+    // прямоугольники задаются включительно и обрезаются по правому и нижнему краю поля
+    bool anyInRect(uint64_t x0, uint64_t y0, uint64_t x1, uint64_t y1, CellState state) const;
+    void fillRect(uint64_t x0, uint64_t y0, uint64_t x1, uint64_t y1, CellState state);
+    void fillEmptyInRect(uint64_t x0, uint64_t y0, uint64_t x1, uint64_t y1, CellState state);
+    uint64_t count(CellState state) const;
+
+    // Упакованный вид для бинарного снимка: плоскости плотного поля как есть или
+    // плитки разреженного по TILE_WORDS слов (x, y плитки и четыре плоскости).
+    static const uint64_t TILE_WORDS = 2 + PLANE_COUNT;
+    uint64_t packedWords() const;
+    void pack(unsigned char* out) const;
+    // подходят ли слова полю w x h; unpack вызывается только после этой проверки
+    // на сброшенном под тот же размер поле, биты за краем поля отбрасываются
+    static bool checkPacked(uint64_t w, uint64_t h, const unsigned char* words, uint64_t count);
+    void unpack(const unsigned char* words, uint64_t count);
+
+    // на разреженном поле EMPTY не перечисляется
+    template <typename F>
+    void forEach(CellState state, F&& fn) const {
+        if (sparse) {
+            if (state == CellState::EMPTY) return;
+            for (const auto& [key, tile] : tiles) {
+                uint64_t word = stateMask(tile.planes, 1, 0, state);
+                while (word) {
+                    uint64_t bit = __builtin_ctzll(word);
+                    fn(key.x * 8 + (bit & 7), key.y * 8 + (bit >> 3));
+                    word &= word - 1;
+                }
+            }
+            return;
+        }
+        for (uint64_t y = 0; y < height; ++y) {
+            for (uint64_t w = 0; w < wordsPerRow; ++w) {
+                uint64_t word = stateWord(y * wordsPerRow + w, state);
+                while (word) {
+                    uint64_t bit = __builtin_ctzll(word);
+                    fn(w * 64 + bit, y);
+                    word &= word - 1;
+                }
+            }
+        }
+    }
+};
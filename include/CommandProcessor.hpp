@@ -1,15 +1,112 @@
 #pragma once
 #include "Game.hpp"
+#include <charconv>
 #include <string>
+#include <string_view>
+
+// Делит строку команды на слова без копирования.
+class CommandTokens {
+private:
+    static constexpr std::string_view SPACES = " \t\r\n";
+
+    std::string_view rest;
+
+public:
+    explicit CommandTokens(std::string_view line) : rest(line) {}
+
+    // следующее слово; пустое, если слов не осталось
+    std::string_view next() {
+        size_t begin = rest.find_first_not_of(SPACES);
+        if (begin == std::string_view::npos) {
+            rest = {};
+            return {};
+        }
+        rest.remove_prefix(begin);
+        std::string_view word = rest.substr(0, rest.find_first_of(SPACES));
+        rest.remove_prefix(word.size());
+        return word;
+    }
+
+    // следующее слово как число; слово должно быть числом целиком
+    template <typename T>
+    bool number(T& value) {
+        std::string_view word = next();
+        auto result = std::from_chars(word.data(), word.data() + word.size(), value);
+        return !word.empty() && result.ec == std::errc() && result.ptr == word.data() + word.size();
+    }
+
+    // остаток строки без пробелов по краям: путь к файлу может содержать пробелы
+    std::string_view tail() {
+        size_t begin = rest.find_first_not_of(SPACES);
+        if (begin == std::string_view::npos) return {};
+        std::string_view text = rest.substr(begin, rest.find_last_not_of(SPACES) - begin + 1);
+        rest = {};
+        return text;
+    }
+};
+
+// Как процессор отвечает на команды.
+enum class ProcessorMode : uint8_t {
+    // человек за терминалом: подробные ответы, меню и поля после ходов
+    CONSOLE,
+    // те же ответы, но без печати в stdout (веб-сервер)
+    SILENT,
+    // только ответы из README (ok, miss, yes, ...) для игры движков между собой
+    PROTOCOL
+};
 
 class CommandProcessor {
 private:
+    using Handler = std::string (CommandProcessor::*)(CommandTokens& args);
+
     Game& game;
+    ProcessorMode mode;
+    // наш последний выстрел в протоколе, его исход придёт командой result
+    uint64_t lastShotX = 0;
+    uint64_t lastShotY = 0;
+    bool shotPending = false;
+
+    bool verbose() const { return mode == ProcessorMode::CONSOLE; }
+    bool protocol() const { return mode == ProcessorMode::PROTOCOL; }
+    // в протоколе любой исход - ok или failed, иначе подробный текст
+    std::string reply(bool ok, const char* text) const;
+    void showBoards() const;
     std::string makeEnemyShot();
-    std::pair<std::string, std::string> parseCommand(const std::string& command);
+    // обработчик по первому слову команды, nullptr для неизвестной
+    static Handler findHandler(std::string_view verb);
+
+    std::string handleCreate(CommandTokens& args);
+    std::string handleStart(CommandTokens& args);
+    std::string handleShot(CommandTokens& args);
+    std::string handleStop(CommandTokens& args);
+    std::string handleDisplay(CommandTokens& args);
+    std::string handleReveal(CommandTokens& args);
+    std::string handleSet(CommandTokens& args);
+    std::string handlePlace(CommandTokens& args);
+    std::string handleSave(CommandTokens& args);
+    std::string handleLoad(CommandTokens& args);
+    std::string handleExit(CommandTokens& args);
+    std::string handlePing(CommandTokens& args);
+    std::string handleGet(CommandTokens& args);
+    std::string handleFinished(CommandTokens& args);
+    std::string handleWin(CommandTokens& args);
+    std::string handleLose(CommandTokens& args);
+    std::string handleDump(CommandTokens& args);
+    std::string handleResult(CommandTokens& args);
 
 public:
-    CommandProcessor(Game& game);
+    // слова команд в порядке обработчиков в findHandler; по номеру слова
+    // Metrics выбирает гистограмму команды
+    static constexpr std::string_view VERBS[] = {
+        "create", "start", "shot", "stop", "display", "reveal", "set", "place", "save",
+        "load", "exit", "ping", "get", "finished", "win", "lose", "dump", "result"
+    };
+    static constexpr size_t VERB_COUNT = sizeof(VERBS) / sizeof(VERBS[0]);
+
+    // номер слова команды в VERBS, VERB_COUNT для неизвестной
+    static size_t verbIndex(std::string_view verb);
+
+    explicit CommandProcessor(Game& game, ProcessorMode mode = ProcessorMode::CONSOLE);
     void run();
-    std::string processCommand(const std::string& command);
+    std::string processCommand(std::string_view command);
 };
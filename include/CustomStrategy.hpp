@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+#include "OrderedStrategy.hpp"
+#include "ShotStrategy.hpp"
+
+// Охота по шахматным клеткам в случайном порядке, после попадания - добивание
+// по соседним клеткам. Когда случайные попытки не находят клетку, добирает по порядку.
+class CustomStrategy : public ShotStrategy {
+private:
+    static const int MAX_ATTEMPTS = 64;
+
+    std::mt19937_64 gen;
+    // раненые, но ещё не потопленные клетки
+    std::vector<std::pair<uint64_t, uint64_t>> hits;
+    OrderedStrategy fallback;
+
+    static bool isUnknown(const Board& board, uint64_t x, uint64_t y);
+
+public:
+    void reset(const Board& board, const int aliveShips[4], uint64_t seed) override;
+    std::pair<uint64_t, uint64_t> nextShot(const Board& board, ShotDeadline deadline) override;
+    void onShot(uint64_t x, uint64_t y, ShootResult result, const Ship* killed) override;
+};
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "Board.hpp"
+#include "Ship.hpp"
+#include "ShotStrategy.hpp"
+
+// Стрельба по плотности вероятности: для каждой неизвестной клетки хранится число
+// допустимых расстановок каждого типа корабля, которые её накрывают. Счётчики
+// пересчитываются только для расстановок, задетых выстрелом и ореолом потопленного корабля.
+// Вес клетки - 1 плюс счётчики типов, корабли которых ещё на плаву, - меняется вместе
+// со счётчиками, а клетки разложены по весам в битовые плоскости, так что выбор
+// выстрела не обходит поле. Всё поле пересчитывается, только когда тип кончается.
+class DensityStrategy : public ShotStrategy {
+private:
+    enum Knowledge : uint8_t {
+        UNKNOWN,
+        BLOCKED,
+        HIT,
+        // выстрел сделан, ответа не было: для расстановок клетка неизвестна,
+        // повторно не выбирается
+        PENDING
+    };
+
+    // 1 + 1 + 2 * 2 + 2 * 3 + 2 * 4: все расстановки всех типов через клетку
+    static const int MAX_SCORE = 20;
+
+    uint64_t width = 0;
+    uint64_t height = 0;
+    int alive[4] = {0, 0, 0, 0};
+    std::vector<uint8_t> cells;
+    // placements[cell * 4 + size - 1]: счётчики клетки лежат рядом; клетку накрывают
+    // не больше 2 * size расстановок одного типа, байта хватает
+    std::vector<uint8_t> placements;
+    // вес клетки, 0 - клетка уже не неизвестна
+    std::vector<uint8_t> scores;
+    // для каждого веса: биты клеток (words слов) и биты непустых слов (summaryWords)
+    uint64_t words = 0;
+    uint64_t summaryWords = 0;
+    std::vector<uint64_t> bucketCells;
+    std::vector<uint64_t> bucketWords;
+    uint64_t bucketSize[MAX_SCORE + 1] = {};
+    std::vector<uint64_t> hits;
+    bool awaitingResult = false;
+    uint64_t lastShot = 0;
+
+    bool isFree(uint64_t x, uint64_t y, int size, bool horizontal) const;
+    void addPlacement(uint64_t x, uint64_t y, int size, bool horizontal, int delta);
+    void block(uint64_t x, uint64_t y);
+    void setScore(uint64_t cell, int score);
+    // первая клетка с наибольшим весом, width * height - если неизвестных нет
+    uint64_t bestCell() const;
+    bool findTargetShot(uint64_t& best) const;
+
+public:
+    void reset(const Board& board, const int aliveShips[4], uint64_t seed) override;
+    std::pair<uint64_t, uint64_t> nextShot(const Board& board, ShotDeadline deadline) override;
+    void onShot(uint64_t x, uint64_t y, ShootResult result, const Ship* killed) override;
+};
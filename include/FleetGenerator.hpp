@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "Ship.hpp"
+
+enum class PlacementResult : uint8_t {
+    OK,
+    INFEASIBLE,
+    GAVE_UP
+};
+
+// Расстановка флота перебором с возвратом по маске свободных клеток: корабли ставятся
+// от больших к меньшим, якорь выбирается только среди допустимых позиций. Якоря
+// упорядочены ключом (направление, строка, столбец); на каждом уровне они перебираются
+// по кругу от случайного ключа, так что испробованные - это отрезок до курсора.
+// Одинаковые корабли взаимозаменяемы и ставятся с возрастающими ключами, каждая
+// расстановка встречается один раз. Число проверенных якорей ограничено бюджетом,
+// растущим с площадью поля, поэтому генерация всегда завершается. На разреженных
+// полях маска не строится, позиции выбираются случайно с отбраковкой.
+class FleetGenerator {
+private:
+    struct Level {
+        // допустимые ключи - от low до keyCount; перебор идёт от start до конца,
+        // затем от low до start
+        uint64_t low;
+        uint64_t start;
+        uint64_t cursor;
+        bool wrapped;
+    };
+
+    uint64_t width = 0;
+    uint64_t height = 0;
+    uint64_t wordsPerRow = 0;
+    uint64_t tailMask = 0;
+    // бит = клетка занята кораблём или его ореолом
+    std::vector<uint64_t> occupied;
+    // сколько поставленных кораблей накрывают клетку ореолом: возврат снимает
+    // один корабль, не пересобирая маску
+    std::vector<uint8_t> cover;
+    std::vector<Level> levels;
+    // ключ якоря, поставленного на каждом уровне
+    std::vector<uint64_t> chosen;
+    std::vector<uint64_t> freeCells;
+    std::vector<uint64_t> cellsLeft;
+
+    void resize(uint64_t w, uint64_t h);
+    // delta 1 ставит корабль с ореолом, -1 снимает, 0 ничего не меняет;
+    // возвращает, сколько клеток прямоугольника было свободно
+    uint64_t occupy(const Ship& ship, int delta);
+    uint64_t freeWord(uint64_t y, uint64_t word) const;
+    uint64_t anchorWord(int size, bool horizontal, uint64_t y, uint64_t word) const;
+    uint64_t keyCount(int size) const;
+    // якоря с ключом не меньше from по порядку ключей: если их больше index, key -
+    // index-й из них; иначе false и count - сколько их всего
+    bool selectAnchor(int size, uint64_t from, uint64_t index, uint64_t& key, uint64_t& count) const;
+    bool isAnchor(int size, uint64_t key) const;
+    bool findAnchor(int size, uint64_t from, uint64_t to, uint64_t& key) const;
+    bool nextAnchor(int size, Level& level, uint64_t& key) const;
+    Ship shipAt(int size, uint64_t key) const;
+    static bool touches(const Ship& a, const Ship& b);
+    static uint64_t luby(uint64_t i);
+    PlacementResult generateSparse(uint64_t w, uint64_t h, const std::vector<int>& sizes,
+                                   std::mt19937_64& gen, std::vector<Ship>& ships);
+
+public:
+    // бюджет якорей на клетку поля и нижняя граница для маленьких полей
+    static const uint64_t NODES_PER_CELL = 32;
+    static const uint64_t MIN_NODES = 1000000;
+    // первый перезапуск - столько якорей на корабль, дальше вдвое больше
+    static const uint64_t RESTART_NODES_PER_SHIP = 4;
+    // случайных ключей на уровень, прежде чем выбирать якорь по номеру
+    static const int ANCHOR_PROBES = 32;
+    static const uint64_t MIN_PROBED_KEYS = 4096;
+    static const int MAX_SPARSE_ATTEMPTS = 1000;
+
+    PlacementResult generate(uint64_t w, uint64_t h, const std::vector<uint8_t>& shipCounts,
+                             std::mt19937_64& gen, std::vector<Ship>& ships);
+    static bool mayFit(uint64_t w, uint64_t h, const std::vector<uint8_t>& shipCounts);
+};
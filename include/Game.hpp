@@ -1,19 +1,21 @@
 #pragma once
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 #include <ostream>
 #include <istream>
 #include <algorithm>
+#include <random>
 #include "Ship.hpp"
-
-enum class CellState : uint8_t {
-    EMPTY,
-    SHIP,
-    HIT,
-    MISS,
-    KILL
-};
+#include "Board.hpp"
+#include "OrderedStrategy.hpp"
+#include "CustomStrategy.hpp"
+#include "DensityStrategy.hpp"
+#include "MonteCarloStrategy.hpp"
+#include "FleetGenerator.hpp"
+#include "Journal.hpp"
 
 enum class GameMode : uint8_t {
     MASTER,
@@ -29,7 +31,9 @@ enum class ShootResult : uint8_t {
 
 enum class Strategy : uint8_t {
     ORDERED,
-    CUSTOM
+    CUSTOM,
+    DENSITY,
+    MONTE_CARLO
 };
 
 inline std::ostream& operator<<(std::ostream& os, const Strategy& strategy) {
@@ -44,71 +48,235 @@ inline std::istream& operator>>(std::istream& is, Strategy& strategy) {
     return is;
 }
 
+struct FleetStatus {
+    uint64_t totalShips = 0;
+    uint64_t aliveShips = 0;
+    uint64_t aliveCells = 0;
+};
+
+// выстрел, о котором Game сообщает наблюдателю
+struct ShotEvent {
+    // true - игрок стреляет по полю противника, false - противник по полю игрока
+    bool byPlayer;
+    uint64_t x;
+    uint64_t y;
+    ShootResult result;
+    // потопленный корабль, только для KILL
+    const Ship* killed;
+    // версия партии после выстрела
+    uint64_t version;
+};
+
+// клетка, изменившаяся в версии version
+struct CellChange {
+    uint64_t version;
+    uint64_t x;
+    uint64_t y;
+    CellState state;
+    // true - поле противника, по которому стреляет игрок
+    bool enemyBoard;
+};
+
+using ShotObserver = std::function<void(const ShotEvent&)>;
+
+// точка отката пробных ходов, см. Game::mark
+struct UndoPoint {
+    size_t logSize;
+    uint64_t version;
+    bool myTurn;
+    // первая точка: откат к ней завершает пробные ходы
+    bool outermost;
+};
+
 class Game {
 private:
+    // поля больше выводятся сводкой вместо сетки
+    static const uint64_t MAX_DISPLAY_SIZE = 100;
+    // журнал изменений ограничен, отставшему клиенту нужен полный снимок
+    static const size_t MAX_CHANGES = 1 << 14;
+    static const uint64_t MAX_TIME_LIMIT = 24 * 60 * 60 * 1000;
+    // shipCounts хранит количество кораблей одного типа в байте
+    static const uint64_t MAX_SHIP_COUNT = UINT8_MAX;
+
     GameMode mode;
     Strategy currentStrategy;
     uint64_t width;
     uint64_t height;
     std::vector<uint8_t> shipCounts;
-    std::vector<std::vector<CellState>> myBoard;
-    std::vector<std::vector<CellState>> enemyBoard;
+    Board myBoard;
+    Board enemyBoard;
     std::vector<Ship> myShips;
     std::vector<Ship> enemyShips;
-    std::vector<std::pair<int, int>> myShots;
-    std::vector<std::pair<int, int>> enemyShots;
+    FleetStatus myFleet;
+    FleetStatus enemyFleet;
+    OrderedStrategy orderedStrategy;
+    CustomStrategy customStrategy;
+    DensityStrategy densityStrategy;
+    MonteCarloStrategy monteCarloStrategy;
+    FleetGenerator fleetGenerator;
+    std::mt19937_64 rng;
+    std::string setupError;
+    ShotObserver shotObserver;
+    uint64_t version = 0;
+    // с этой версии журнал полон: раньше была перестройка полей или обрезка
+    uint64_t oldestVersion = 0;
+    bool trackChanges = false;
+    // ограничение на выбор выстрела в миллисекундах, 0 - без ограничения
+    uint64_t timeLimit = 0;
+    // зерно последней пересборки стратегии, хранится в снимке
+    uint64_t strategySeed = 0;
+    std::vector<CellChange> changes;
+    // пробный выстрел: всё, что нужно, чтобы вернуть поле, корабль и флот
+    struct ShotUndo {
+        uint64_t x;
+        uint64_t y;
+        // KILL: клетки ореола, которые были пустыми до потопления
+        uint32_t haloMask;
+        // 0 - промах
+        uint16_t shipId;
+        bool byPlayer;
+        ShootResult result;
+    };
+    std::vector<ShotUndo> undoLog;
+    bool speculating = false;
+    // ореол, посчитанный hitShip для записи в undoLog
+    uint32_t killHalo = 0;
+    std::unique_ptr<Journal> journal;
+    std::string journalPath;
+    // последнее событие журнала, учтённое в партии
+    uint64_t journalSequence = 0;
     bool myTurn = true;
     bool gameStarted = false;
     bool gameEnded = false;
     bool placementPhase = true;
+    // соперник - другой движок по протоколу: его флот не известен, enemyBoard - наше
+    // знание о его поле по ответам на наши выстрелы, enemyShips - потопленные корабли
+    bool remoteOpponent = false;
     int remainingShips[4] = {1, 2, 3, 4};
 
     void initializeBoards();
     bool canPlaceShip(uint64_t x, uint64_t y, int size, bool horizontal) const;
     bool isValidPlacement(const Ship& ship) const;
     bool shipsOverlap(const Ship& ship1, const Ship& ship2) const;
-    void markAroundShip(const Ship& ship, std::vector<std::vector<CellState>>& board);
+    void markAroundShip(const Ship& ship, Board& board);
     bool canPlaceEnemyShip(uint64_t x, uint64_t y, int size, bool horizontal);
     bool placeEnemyShip(uint64_t x, uint64_t y, int size, bool horizontal);
-    bool isValidGameSetup() const;
-    bool tryHitShip(uint64_t x, uint64_t y, Ship& ship);
-    std::pair<uint64_t, uint64_t> getNextOrderedShot();
-    std::pair<uint64_t, uint64_t> getNextCustomShot();
+    void addShip(const Ship& ship, std::vector<Ship>& ships, Board& board, FleetStatus& fleet);
+    bool isValidGameSetup(std::string& error) const;
+    ShootResult hitShip(uint64_t x, uint64_t y, Ship& ship, Board& board, FleetStatus& fleet);
+    void recordShot(bool byPlayer, uint64_t x, uint64_t y, ShootResult result, const Ship* killed);
+    void logRect(const Board& board, bool enemy, uint64_t x0, uint64_t y0, uint64_t x1, uint64_t y1);
+    void markRebuilt();
+    ShotStrategy& activeStrategy();
+    void resetStrategy();
+    void resetStrategy(uint64_t seed);
+    void journalEvent(JournalEvent event, uint64_t x = 0, uint64_t y = 0, uint8_t size = 0, uint8_t horizontal = 0);
+    bool replay(const JournalRecord& record);
+    bool checkpoint();
+    static void haloRect(const Ship& ship, const Board& board, uint64_t& x0, uint64_t& y0, uint64_t& x1, uint64_t& y1);
+    uint32_t emptyHalo(const Ship& ship, const Board& board) const;
+    void undoShot(const ShotUndo& shot);
+    bool restoreShips(const unsigned char* records, uint64_t count, std::vector<Ship>& ships,
+                      Board& board, FleetStatus& fleet, bool sunkOnly = false);
+    // поле, по которому стреляет наша стратегия, и корабли на нём
+    const Board& targetBoard() const { return remoteOpponent ? enemyBoard : myBoard; }
+    const std::vector<Ship>& targetShips() const { return remoteOpponent ? enemyShips : myShips; }
+    // флот удалённого соперника: правила те же, живы все, кроме потопленных
+    FleetStatus remoteFleet() const;
 
 public:
     Game();
     bool createGame(const std::string& mode);
     bool setStrategy(const std::string& strategy);
+    bool setMonteCarloOptions(uint64_t threads, uint64_t samples);
+    // срок на каждый getNextShot; 0 снимает ограничение, больше суток - ошибка
+    bool setTimeLimit(uint64_t milliseconds);
+    uint64_t getTimeLimit() const { return timeLimit; }
+    void setSeed(uint64_t seed) { rng.seed(seed); }
+    // вызывается после каждого засчитанного выстрела обеих сторон
+    void setShotObserver(ShotObserver observer) { shotObserver = std::move(observer); }
+    // версия растёт при каждом изменении полей
+    uint64_t getVersion() const { return version; }
+    // журнал клеток для getChangesSince; выключен, чтобы не тратить память в турнирах
+    void setChangeTracking(bool enabled);
+    // клетки, изменённые после since, по возрастанию версии; false - журнал
+    // их уже не содержит (перестройка полей, обрезка) и нужен полный снимок
+    bool getChangesSince(uint64_t since, std::vector<CellChange>& out) const;
     bool setWidth(uint64_t w);
     bool setHeight(uint64_t h);
     bool setShipCount(int shipSize, uint64_t count);
     uint64_t getWidth() const;
     uint64_t getHeight() const;
     uint64_t getShipCount(int shipSize) const;
-    void resetBoards() { initializeBoards(); }
+    void resetBoards() {
+        if (speculating) return;
+        initializeBoards();
+        if (journal) checkpoint();
+    }
     bool startGame();
+    // причина последнего неудачного startGame
+    const std::string& getSetupError() const { return setupError; }
     bool stopGame();
     bool isFinished() const;
     bool isWinner() const;
     bool isLoser() const;
-    bool placeShip(int x, int y, int size, bool horizontal);
+    bool placeShip(uint64_t x, uint64_t y, int size, bool horizontal);
     bool canPlaceShip(int size) const {
         if (size < 1 || size > 4) return false;
         return remainingShips[size - 1] > 0;
     }
     ShootResult processShot(uint64_t x, uint64_t y);
     std::pair<uint64_t, uint64_t> getNextShot();
+    // Игра с другим движком: наши выстрелы - getNextShot, их исход сообщает соперник
+    // через applyShotResult, его выстрелы по нам - processEnemyShot. Своего флота
+    // соперника партия не заводит, стратегия учится только на ответах о наших выстрелах.
+    void setRemoteOpponent(bool remote) { remoteOpponent = remote; }
+    bool isRemoteOpponent() const { return remoteOpponent; }
+    // исход нашего выстрела по полю соперника; KILL собирает корабль из соседних HIT
+    bool applyShotResult(uint64_t x, uint64_t y, ShootResult result);
     void displayBoards() const;
     void displayEnemyShips() const;
+    // текстовый формат из README: размер поля и расстановка своих кораблей;
+    // loadFromFile читает и его, и бинарный снимок
     bool saveToFile(const std::string& path) const;
     bool loadFromFile(const std::string& path);
-    void generateRandomShipPlacement();
+    // бинарный снимок всей партии (GameSnapshot.hpp): поля, флоты, очередь хода,
+    // стратегия и её настройки. Снимок с неверной суммой или раскладкой партию
+    // не меняет; если корабли не сходятся с полями, партия остаётся пустой
+    void writeSnapshot(std::string& out) const;
+    bool readSnapshot(const void* data, size_t size);
+    bool saveSnapshot(const std::string& path) const;
+    // файл отображается в память и читается без разбора
+    bool loadSnapshot(const std::string& path);
+    // Пробные ходы для перебора вперёд. mark запоминает точку, после неё выстрелы
+    // обеих сторон и смена хода записываются в журнал отката, а undo возвращает
+    // партию к точке за время, пропорциональное числу изменений, без выделений
+    // памяти. Пробные выстрелы не видны наблюдателю, журналу изменений и журналу
+    // восстановления; стратегия о них не узнаёт и остаётся в состоянии первой точки.
+    // Прочие изменения партии до отката или commit отклоняются.
+    UndoPoint mark();
+    void undo(const UndoPoint& point);
+    // оставить пробные ходы как настоящие
+    void commit();
+    bool isSpeculating() const { return speculating; }
+    // Журнал для восстановления после падения: path.snap - снимок, path.journal -
+    // выстрелы, расстановка, правила, стратегия и очерёдность хода после него.
+    // Создание и сброс партии, старт и загрузка сразу записывают новый снимок. Если
+    // снимок уже есть, партия сначала восстанавливается из него и хвоста журнала.
+    bool openJournal(const std::string& path);
+    void closeJournal();
+    PlacementResult generateRandomShipPlacement();
     bool isCurrentTurn() const { return myTurn; }
-    void switchTurn() { myTurn = !myTurn; }
+    void switchTurn() {
+        myTurn = !myTurn;
+        journalEvent(JournalEvent::SWITCH_TURN);
+    }
     ShootResult processEnemyShot(uint64_t x, uint64_t y);
     bool isValidPosition(uint64_t x, uint64_t y) const;
     const std::vector<Ship>& getMyShips() const { return myShips; }
+    const FleetStatus& getMyFleet() const { return myFleet; }
+    const FleetStatus& getEnemyFleet() const { return enemyFleet; }
 
-    const std::vector<std::vector<CellState>>& getPlayerBoard() const { return myBoard; }
-    const std::vector<std::vector<CellState>>& getEnemyBoard() const { return enemyBoard; }
+    const Board& getPlayerBoard() const { return myBoard; }
+    const Board& getEnemyBoard() const { return enemyBoard; }
 };
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Бинарный снимок партии для Game::writeSnapshot / readSnapshot.
+// Заголовок, записи кораблей и упакованные поля (Board::pack) идут подряд в порядке
+// байт машины, всё выровнено на 8 байт. Чтение - проверка заголовка и суммы и
+// копирование блоков как есть, без разбора, поэтому файл можно просто отобразить
+// в память. На машине с другим порядком байт не совпадёт сигнатура.
+namespace snapshot {
+
+// "SEABATTL" в little-endian
+const uint64_t MAGIC = 0x4C54544142414553ULL;
+// растёт при любом изменении раскладки, старые версии не читаются
+const uint32_t VERSION = 2;
+
+enum Flags : uint8_t {
+    MY_TURN = 1,
+    STARTED = 2,
+    PLACEMENT = 4,
+    // enemyShips - только потопленные корабли удалённого соперника
+    REMOTE = 8
+};
+
+struct Header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t headerSize;
+    // слов после заголовка
+    uint64_t payloadWords;
+    // сумма всего, что лежит после этого поля, включая остаток заголовка
+    uint64_t checksum;
+    uint64_t width;
+    uint64_t height;
+    uint64_t shipCounts[4];
+    int64_t remainingShips[4];
+    uint64_t timeLimit;
+    uint64_t monteCarloThreads;
+    uint64_t monteCarloSamples;
+    // зерно, с которым стратегия собиралась в последний раз
+    uint64_t strategySeed;
+    // последняя запись журнала, уже вошедшая в снимок
+    uint64_t journalSequence;
+    uint64_t myShips;
+    uint64_t enemyShips;
+    uint64_t myBoardWords;
+    uint64_t enemyBoardWords;
+    uint8_t mode;
+    uint8_t strategy;
+    uint8_t flags;
+    uint8_t reserved[5];
+};
+
+struct ShipRecord {
+    uint64_t x;
+    uint64_t y;
+    uint8_t size;
+    uint8_t horizontal;
+    uint8_t hitMask;
+    uint8_t reserved[5];
+};
+
+static_assert(sizeof(Header) % 8 == 0, "header keeps the payload word-aligned");
+static_assert(sizeof(ShipRecord) == 3 * sizeof(uint64_t), "ship record is three words");
+
+// с этого смещения считается контрольная сумма
+const size_t CHECKED_FROM = offsetof(Header, checksum) + sizeof(uint64_t);
+
+// сумма слов в четыре независимые цепочки; size кратен 8
+uint64_t checksum(const unsigned char* data, size_t size);
+
+} // namespace snapshot
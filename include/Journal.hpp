@@ -0,0 +1,105 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Событие, изменившее партию после последнего снимка.
+enum class JournalEvent : uint8_t {
+    PLAYER_SHOT,
+    ENEMY_SHOT,
+    PLACE_SHIP,
+    // x - зерно стратегии, size - Strategy
+    SET_STRATEGY,
+    SWITCH_TURN,
+    STOP_GAME,
+    // правила до старта: x - новое значение, у SET_SHIP_COUNT size - палубность
+    SET_WIDTH,
+    SET_HEIGHT,
+    SET_SHIP_COUNT,
+    SET_TIME_LIMIT,
+    // x - потоки, y - выборки
+    SET_MONTE_CARLO,
+    // ответ удалённого соперника на наш выстрел в (x, y), size - ShootResult
+    SHOT_RESULT
+};
+
+struct JournalRecord {
+    // номера идут подряд; разрыв - конец годной части журнала
+    uint64_t sequence;
+    uint64_t x;
+    uint64_t y;
+    JournalEvent event;
+    uint8_t size;
+    uint8_t horizontal;
+    uint8_t reserved;
+    // сумма предыдущих байтов записи, ловит оборванную запись в хвосте
+    uint32_t checksum;
+};
+
+static_assert(sizeof(JournalRecord) == 32, "journal record is four words");
+
+// Журнал на дозапись для восстановления после падения. Файл отображён в память
+// (MAP_SHARED), запись - копирование 32 байт в страничный кеш ядра, так что падение
+// процесса её не теряет, а системного вызова на выстрел нет. msync делает фоновый
+// поток раз в SYNC_INTERVAL и только для страниц, записанных с прошлого раза, - при
+// потере питания пропадает не больше этого окна. Файл растёт кусками по GROW_BYTES.
+// Без mmap (Windows) запись уходит в файл одним write.
+class Journal {
+private:
+    static const size_t GROW_BYTES = 64 * 1024;
+
+    int fd = -1;
+    unsigned char* base = nullptr;
+    // отображено и выделено в файле; меняется только под mutex
+    size_t capacity = 0;
+    // занято записями
+    size_t used = 0;
+    uint64_t nextSequence = 1;
+    // после неудачной записи хвост испорчен, дальше не пишем
+    bool broken = false;
+    std::atomic<bool> dirty{false};
+    // sync сбрасывает только байты [synced, written): записанное после прошлого раза
+    std::atomic<size_t> written{0};
+    size_t synced = 0;
+    // файл удлинялся после прошлого sync, новый размер сбросит только fsync
+    bool grown = false;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread syncer;
+
+    void run();
+    bool resize(size_t bytes);
+    static uint32_t checksum(const JournalRecord& record);
+
+public:
+    static constexpr std::chrono::milliseconds SYNC_INTERVAL{5};
+
+    Journal() = default;
+    ~Journal();
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // открывает файл на дозапись и отрезает оборванный хвост; номера продолжаются
+    // после последней записи в файле, но не раньше after
+    bool open(const std::string& path, uint64_t after);
+    void close();
+    bool isOpen() const { return fd >= 0; }
+    // номер последней выданной записи, в том числе не записанной
+    uint64_t lastSequence() const { return nextSequence - 1; }
+    // номер записи или 0, если записать не удалось; номер всё равно расходуется,
+    // чтобы восстановление остановилось на пропуске
+    uint64_t append(JournalEvent event, uint64_t x, uint64_t y, uint8_t size = 0, uint8_t horizontal = 0);
+    // записи до этого момента на диске
+    void sync();
+    // всё записанное уже вошло в снимок
+    bool clear();
+
+    // годные записи с начала файла; отсутствующий файл - пустой журнал
+    static bool read(const std::string& path, std::vector<JournalRecord>& records);
+};
@@ -0,0 +1,132 @@
+#pragma once
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+
+enum class LogLevel : uint8_t {
+    DEBUG,
+    INFO,
+    WARN,
+    ERROR
+};
+
+// Вызовы ниже этого уровня вырезаются при компиляции вместе с вычислением аргументов.
+#ifndef SEA_BATTLE_MIN_LOG_LEVEL
+#ifdef NDEBUG
+#define SEA_BATTLE_MIN_LOG_LEVEL 1
+#else
+#define SEA_BATTLE_MIN_LOG_LEVEL 0
+#endif
+#endif
+
+// Сообщение в кольцевом буфере; длинные сообщения обрезаются.
+struct LogRecord {
+    static const size_t TEXT_SIZE = 236;
+
+    // system_clock, микросекунды от эпохи
+    int64_t time;
+    LogLevel level;
+    uint16_t length;
+    char text[TEXT_SIZE];
+};
+
+// Асинхронный журнал. Вызывающий поток форматирует сообщение на стеке без
+// выделений памяти и кладёт его в ограниченную lock-free очередь (схема Вьюкова);
+// фоновый поток выводит накопленное пачками. Если очередь полна, сообщение
+// отбрасывается и учитывается в dropped - обработка запросов не ждёт вывода.
+// DEBUG и INFO идут в stdout, WARN и ERROR в stderr.
+class Logger {
+private:
+    static const size_t CAPACITY = 4096;
+
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        LogRecord record;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    alignas(64) std::atomic<uint64_t> enqueuePos{0};
+    // читается только фоновым потоком
+    alignas(64) uint64_t dequeuePos = 0;
+    std::atomic<LogLevel> minLevel{LogLevel::INFO};
+    std::atomic<uint64_t> droppedCount{0};
+    std::atomic<bool> stopping{false};
+    std::once_flag started;
+    std::thread worker;
+
+    Logger();
+    void push(const LogRecord& record);
+    bool drain();
+    void run();
+
+    static void appendText(LogRecord& record, std::string_view text) {
+        size_t room = LogRecord::TEXT_SIZE - record.length;
+        size_t count = text.size() < room ? text.size() : room;
+        std::memcpy(record.text + record.length, text.data(), count);
+        record.length += static_cast<uint16_t>(count);
+    }
+
+    template <typename T>
+    static void append(LogRecord& record, const T& value) {
+        if constexpr (std::is_same_v<T, bool>) {
+            appendText(record, value ? "true" : "false");
+        } else if constexpr (std::is_same_v<T, char>) {
+            appendText(record, std::string_view(&value, 1));
+        } else if constexpr (std::is_arithmetic_v<T>) {
+            char buffer[32];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            appendText(record, std::string_view(buffer, result.ptr - buffer));
+        } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            appendText(record, std::string_view(value));
+        } else {
+            // string_view из Boost и прочие последовательности символов
+            appendText(record, std::string_view(value.data(), value.size()));
+        }
+    }
+
+public:
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+    ~Logger();
+
+    static Logger& instance();
+    // разбирает debug/info/warn/error
+    static bool parseLevel(std::string_view text, LogLevel& level);
+
+    bool enabled(LogLevel level) const { return level >= minLevel.load(std::memory_order_relaxed); }
+    void setLevel(LogLevel level) { minLevel.store(level, std::memory_order_relaxed); }
+    uint64_t dropped() const { return droppedCount.load(std::memory_order_relaxed); }
+
+    template <typename... Args>
+    void write(LogLevel level, const Args&... args) {
+        LogRecord record;
+        record.time = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        record.level = level;
+        record.length = 0;
+        (append(record, args), ...);
+        push(record);
+    }
+};
+
+#define LOG_AT(level, ...)                                                          \
+    do {                                                                            \
+        if constexpr (static_cast<int>(level) >= SEA_BATTLE_MIN_LOG_LEVEL) {        \
+            if (Logger::instance().enabled(level)) {                                \
+                Logger::instance().write(level, __VA_ARGS__);                       \
+            }                                                                       \
+        }                                                                           \
+    } while (0)
+
+#define LOG_DEBUG(...) LOG_AT(LogLevel::DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LogLevel::INFO, __VA_ARGS__)
+#define LOG_WARN(...) LOG_AT(LogLevel::WARN, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LogLevel::ERROR, __VA_ARGS__)
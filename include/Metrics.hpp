@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Счётчики движка.
+enum class Counter : uint8_t {
+    PLAYER_SHOTS,
+    ENEMY_SHOTS,
+    PLACEMENT_ATTEMPTS,
+    COUNT
+};
+
+// Гистограммы длительности; метка у каждой своя, семейство задаёт таблица в Metrics.cpp.
+enum class Histogram : uint8_t {
+    ROUTE_GAME_STATE,
+    ROUTE_SHOTS,
+    ROUTE_SHIPS,
+    ROUTE_COMMAND,
+    ROUTE_CHANGES,
+    ROUTE_STATIC,
+    ROUTE_METRICS,
+    // команды по номеру в CommandProcessor::VERBS, за ними неизвестная
+    VERB_FIRST,
+    VERB_UNKNOWN = VERB_FIRST + 18,
+    // порядок совпадает с enum Strategy
+    DECISION_ORDERED,
+    DECISION_CUSTOM,
+    DECISION_DENSITY,
+    DECISION_MONTE_CARLO,
+    COUNT
+};
+
+// Метрики для /metrics. Каждый поток пишет только в свой блок, поэтому запись -
+// это load и store без блокировок и атомарных RMW; блоки складываются лишь
+// при чтении в render. Блок живёт и после завершения потока, счёт не теряется.
+class Metrics {
+public:
+    // границы корзин в микросекундах, последняя корзина - +Inf
+    static const size_t BUCKET_COUNT = 16;
+    static const uint64_t BUCKET_BOUNDS_US[BUCKET_COUNT - 1];
+
+    struct HistogramData {
+        std::atomic<uint64_t> buckets[BUCKET_COUNT];
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> sumNanos;
+    };
+
+    struct ThreadBlock {
+        std::atomic<uint64_t> counters[static_cast<size_t>(Counter::COUNT)];
+        HistogramData histograms[static_cast<size_t>(Histogram::COUNT)];
+    };
+
+    static void add(Counter counter, uint64_t value = 1) {
+        bump(local().counters[static_cast<size_t>(counter)], value);
+    }
+
+    static void observe(Histogram histogram, std::chrono::nanoseconds duration);
+
+    // гистограмма команды по первому слову строки
+    static Histogram commandHistogram(std::string_view command);
+
+    // текстовый формат Prometheus
+    static std::string render();
+
+private:
+    // пишет только поток-владелец, так что обычного store достаточно
+    static void bump(std::atomic<uint64_t>& value, uint64_t delta) {
+        value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    static ThreadBlock& local() {
+        thread_local ThreadBlock* block = registerThread();
+        return *block;
+    }
+
+    static ThreadBlock* registerThread();
+};
+
+// Замеряет время жизни объекта.
+class MetricTimer {
+private:
+    Histogram histogram;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit MetricTimer(Histogram histogram) : histogram(histogram), start(std::chrono::steady_clock::now()) {}
+    ~MetricTimer() { Metrics::observe(histogram, std::chrono::steady_clock::now() - start); }
+};
+
+// Движок собирается и в турнир с бенчмарком, где метрики не нужны: там
+// макросы пустые и не стоят ничего. Сервер включает их через SEA_BATTLE_METRICS.
+#ifdef SEA_BATTLE_METRICS
+#define METRIC_ADD(counter, value) Metrics::add(counter, value)
+#define METRIC_TIMER(name, histogram) MetricTimer name(histogram)
+#else
+#define METRIC_ADD(counter, value) ((void)0)
+#define METRIC_TIMER(name, histogram) ((void)0)
+#endif
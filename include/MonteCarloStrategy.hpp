@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "Board.hpp"
+#include "Ship.hpp"
+#include "DensityStrategy.hpp"
+#include "ShotStrategy.hpp"
+#include "ThreadPool.hpp"
+
+// Монте-Карло: на пуле потоков генерируется много расстановок флота, согласованных
+// с известными промахами, попаданиями и ореолами потопленных кораблей, и выбирается
+// неизвестная клетка, занятая кораблём в наибольшем числе выборок. Выборки делятся
+// на threadCount задач, которые выполняет общий пул процесса. С крайним сроком
+// выборки прекращаются, когда он наступает, и ответ строится по уже набранным.
+// Если ни одна выборка не сложилась, выстрел выбирается по плотности.
+class MonteCarloStrategy : public ShotStrategy {
+private:
+    enum Knowledge : uint8_t {
+        UNKNOWN,
+        BLOCKED,
+        HIT,
+        // выстрел без ответа: сюда не стреляем, но корабль здесь стоять может
+        PENDING
+    };
+
+    struct Placement {
+        uint64_t x;
+        uint64_t y;
+        int size;
+        bool horizontal;
+    };
+
+    struct Worker {
+        std::vector<uint32_t> counts;
+        std::vector<uint32_t> stamps;
+        uint32_t stamp = 0;
+        uint64_t seed = 0;
+    };
+
+    uint64_t width = 0;
+    uint64_t height = 0;
+    int alive[4] = {0, 0, 0, 0};
+    std::vector<uint8_t> cells;
+    std::vector<uint64_t> hits;
+    bool awaitingResult = false;
+    uint64_t lastShot = 0;
+
+    size_t threadCount = std::thread::hardware_concurrency();
+    size_t sampleCount = 2000;
+    std::vector<Worker> workers;
+    // ведётся через onShot вместе с основной, чтобы после срока не пересобирать поле
+    DensityStrategy fallback;
+    uint64_t shotNumber = 0;
+
+    std::vector<std::vector<Placement>> groupPlacements() const;
+    bool fits(const Worker& worker, const Placement& p) const;
+    void occupy(Worker& worker, const Placement& p) const;
+    void sample(Worker& worker, size_t samples, const std::vector<std::vector<Placement>>& groups,
+                ShotDeadline deadline) const;
+
+public:
+    void configure(size_t threads, size_t samples);
+    size_t getThreads() const { return threadCount; }
+    size_t getSamples() const { return sampleCount; }
+    void reset(const Board& board, const int aliveShips[4], uint64_t seed) override;
+    std::pair<uint64_t, uint64_t> nextShot(const Board& board, ShotDeadline deadline) override;
+    void onShot(uint64_t x, uint64_t y, ShootResult result, const Ship* killed) override;
+};
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+#include "ShotStrategy.hpp"
+
+// Построчно с (0, 0), пропуская клетки с известным результатом.
+class OrderedStrategy : public ShotStrategy {
+private:
+    uint64_t nextX = 0;
+    uint64_t nextY = 0;
+
+public:
+    void reset(const Board& board, const int aliveShips[4], uint64_t seed) override;
+    std::pair<uint64_t, uint64_t> nextShot(const Board& board, ShotDeadline deadline) override;
+    void onShot(uint64_t x, uint64_t y, ShootResult result, const Ship* killed) override;
+};
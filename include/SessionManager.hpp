@@ -0,0 +1,80 @@
+#pragma once
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/strand.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Game.hpp"
+#include "CommandProcessor.hpp"
+
+// Получатель событий партии, например открытый поток SSE.
+class SessionSubscriber {
+public:
+    virtual ~SessionSubscriber() = default;
+    // вызывается на strand сессии; одна строка события разделяется всеми получателями
+    virtual void deliver(std::shared_ptr<const std::string> event) = 0;
+};
+
+// Независимая партия веб-клиента. Game и CommandProcessor связаны ссылкой,
+// поэтому сессия живёт в shared_ptr и не перемещается; все обращения к партии
+// идут через strand, так что запросы к ней выполняются по одному и по порядку.
+struct Session {
+    boost::asio::strand<boost::asio::io_context::executor_type> strand;
+    Game game;
+    CommandProcessor processor{game, ProcessorMode::SILENT};
+    // время последнего обращения в тиках steady_clock, обновляется без блокировки
+    std::atomic<int64_t> lastAccess{0};
+    // подписчики держатся слабо: закрытое соединение просто выпадает из списка
+    std::vector<std::weak_ptr<SessionSubscriber>> subscribers;
+
+    explicit Session(boost::asio::io_context& ioc) : strand(boost::asio::make_strand(ioc)) {
+        // веб-клиенты дочитывают изменения через /changes
+        game.setChangeTracking(true);
+    }
+
+    // subscribe и publish вызываются только на strand
+    void subscribe(std::weak_ptr<SessionSubscriber> subscriber) { subscribers.push_back(std::move(subscriber)); }
+    void publish(std::string event);
+    bool hasSubscribers() const { return !subscribers.empty(); }
+
+    void touch() { lastAccess.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed); }
+};
+
+// Реестр сессий по идентификатору. Таблица разбита на шарды со своими мьютексами,
+// так что поиск в разных шардах не конкурирует; простаивающие сессии удаляет expire.
+class SessionManager {
+private:
+    static const size_t SHARD_COUNT = 64;
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, std::shared_ptr<Session>> sessions;
+    };
+
+    boost::asio::io_context& ioc;
+    std::array<Shard, SHARD_COUNT> shards;
+    std::atomic<size_t> count{0};
+
+    Shard& shardFor(const std::string& id) { return shards[std::hash<std::string>{}(id) % SHARD_COUNT]; }
+    static std::string generateId();
+
+public:
+    explicit SessionManager(boost::asio::io_context& ioc) : ioc(ioc) {}
+
+    // nullptr, если сессии нет или она уже удалена
+    std::shared_ptr<Session> find(const std::string& id);
+    // новая сессия, её идентификатор записывается в id
+    std::shared_ptr<Session> create(std::string& id);
+    // существующая сессия или новая, если id пуст или неизвестен; created сообщает, что id изменился
+    std::shared_ptr<Session> acquire(std::string& id, bool& created);
+    // удаляет сессии без обращений дольше idle, возвращает число удалённых
+    size_t expire(std::chrono::steady_clock::duration idle);
+    size_t size() const { return count.load(std::memory_order_relaxed); }
+};
@@ -8,11 +8,19 @@ private:
     uint64_t y;
     uint8_t size;
     bool horizontal;
-    std::vector<bool> hits;
+    uint8_t hitMask;
+    uint8_t remaining;
 
 public:
     Ship(uint64_t x, uint64_t y, uint8_t size, bool horizontal)
-        : x(x), y(y), size(size), horizontal(horizontal), hits(size, false) {}
+        : x(x), y(y), size(size), horizontal(horizontal), hitMask(0), remaining(size) {}
+
+    // корабль из снимка вместе с уже поражёнными палубами
+    Ship(uint64_t x, uint64_t y, uint8_t size, bool horizontal, uint8_t hits)
+        : Ship(x, y, size, horizontal) {
+        hitMask = hits & ((1 << size) - 1);
+        remaining = size - __builtin_popcount(hitMask);
+    }
 
     bool containsPosition(uint64_t posX, uint64_t posY) const {
         if (horizontal) {
@@ -26,20 +34,31 @@ public:
     uint64_t getY() const { return y; }
     uint8_t getSize() const { return size; }
     bool isHorizontal() const { return horizontal; }
+    uint64_t getEndX() const { return horizontal ? x + size - 1 : x; }
+    uint64_t getEndY() const { return horizontal ? y : y + size - 1; }
+    
+    uint8_t getRemaining() const { return remaining; }
+    uint8_t getHitMask() const { return hitMask; }
     
     bool tryHit(uint64_t posX, uint64_t posY) {
         if (!containsPosition(posX, posY)) return false;
-        int index = horizontal ? posX - x : posY - y;
-        if (hits[index]) return false;
-        hits[index] = true;
+        uint8_t bit = 1 << (horizontal ? posX - x : posY - y);
+        if (hitMask & bit) return false;
+        hitMask |= bit;
+        --remaining;
         return true;
     }
 
+    // отмена tryHit для пробных ходов
+    void undoHit(uint64_t posX, uint64_t posY) {
+        uint8_t bit = 1 << (horizontal ? posX - x : posY - y);
+        if (!(hitMask & bit)) return;
+        hitMask &= ~bit;
+        ++remaining;
+    }
+
     bool isDestroyed() const {
-        for (bool hit : hits) {
-            if (!hit) return false;
-        }
-        return true;
+        return remaining == 0;
     }
 
     std::vector<std::pair<int, int>> getOccupiedCells() const {
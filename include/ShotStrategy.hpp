@@ -0,0 +1,24 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include "Board.hpp"
+#include "Ship.hpp"
+
+enum class ShootResult : uint8_t;
+
+// Крайний срок выбора выстрела; ShotDeadline::max() - без ограничения.
+using ShotDeadline = std::chrono::steady_clock::time_point;
+
+// Стратегия выбора выстрела. Состояние целиком принадлежит объекту, которым владеет
+// Game, поэтому партии в одном процессе независимы. reset пересобирает знание
+// с доски, переиспользуя уже выделенную память; SHIP на доске для стреляющего не виден.
+class ShotStrategy {
+public:
+    virtual ~ShotStrategy() = default;
+    virtual void reset(const Board& board, const int aliveShips[4], uint64_t seed) = 0;
+    // Дорогая стратегия уточняет ответ, пока не наступил deadline, и возвращает лучший
+    // найденный; дешёвая отвечает сразу и на срок не смотрит.
+    virtual std::pair<uint64_t, uint64_t> nextShot(const Board& board, ShotDeadline deadline) = 0;
+    virtual void onShot(uint64_t x, uint64_t y, ShootResult result, const Ship* killed) = 0;
+};
@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Постоянный пул потоков: parallelFor раздаёт индексы задач рабочим потокам
+// и вызывающему потоку и возвращается, когда выполнены все задачи. Вызовы
+// parallelFor из разных потоков выполняются по очереди.
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::condition_variable finished;
+    std::mutex callMutex;
+    const std::function<void(size_t)>* job = nullptr;
+    size_t jobSize = 0;
+    std::atomic<size_t> nextTask{0};
+    size_t activeWorkers = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+
+    void workerLoop();
+    void runTasks(const std::function<void(size_t)>& fn, size_t count);
+
+public:
+    explicit ThreadPool(size_t threads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // один пул на процесс по числу ядер: партии всех сессий делят его,
+    // а не заводят свои потоки
+    static ThreadPool& shared();
+
+    size_t size() const { return workers.size() + 1; }
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+};
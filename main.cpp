@@ -3,9 +3,29 @@
 #include "include/Game.hpp"
 #include "include/CommandProcessor.hpp"
 
-int main() {
+int main(int argc, char* argv[]) {
+    // -q: тихий режим протокола из README для игры с другим движком
+    // --journal PATH: партия переживает падение, при перезапуске восстанавливается
+    ProcessorMode mode = ProcessorMode::CONSOLE;
+    std::string journalPath;
+    for (int i = 1; i < argc; ++i) {
+        std::string flag = argv[i];
+        if (flag == "-q" || flag == "--quiet") {
+            mode = ProcessorMode::PROTOCOL;
+        } else if (flag == "--journal" && i + 1 < argc) {
+            journalPath = argv[++i];
+        } else {
+            std::cerr << "Usage: sea_battle [-q] [--journal <path>]\n";
+            return 1;
+        }
+    }
+
     Game game;
-    CommandProcessor processor(game);
+    if (!journalPath.empty() && !game.openJournal(journalPath)) {
+        std::cerr << "Cannot open journal " << journalPath << '\n';
+        return 1;
+    }
+    CommandProcessor processor(game, mode);
     processor.run();
     return 0;
 }
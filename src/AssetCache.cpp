@@ -0,0 +1,84 @@
+#include "../include/AssetCache.hpp"
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+// FNV-1a: для ETag нужна устойчивость к изменениям файла, а не криптостойкость
+std::string makeEtag(const std::string& data, const char* suffix) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : data) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    static const char HEX[] = "0123456789abcdef";
+    std::string etag = "\"";
+    for (int shift = 60; shift >= 0; shift -= 4) {
+        etag.push_back(HEX[(hash >> shift) & 15]);
+    }
+    return etag + suffix + "\"";
+}
+
+std::string gzip(const std::string& data) {
+#ifdef HAVE_ZLIB
+    z_stream stream{};
+    // 15 + 16 - окно 32 КБ с заголовком gzip вместо zlib
+    if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK) return {};
+    std::string out(deflateBound(&stream, data.size()), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    stream.avail_out = static_cast<uInt>(out.size());
+    int status = deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return status == Z_STREAM_END ? out : std::string();
+#else
+    (void)data;
+    return {};
+#endif
+}
+
+} // namespace
+
+std::string AssetCache::contentTypeFor(const std::filesystem::path& path) {
+    std::string extension = path.extension().string();
+    if (extension == ".html") return "text/html";
+    if (extension == ".css") return "text/css";
+    if (extension == ".js") return "application/javascript";
+    return "application/octet-stream";
+}
+
+size_t AssetCache::load(const std::filesystem::path& root) {
+    assets.clear();
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(root, ec)) {
+        if (!entry.is_regular_file(ec)) continue;
+
+        std::ifstream file(entry.path(), std::ios::binary);
+        if (!file) continue;
+        Asset asset;
+        asset.contentType = contentTypeFor(entry.path());
+        asset.body.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        asset.etag = makeEtag(asset.body, "");
+        asset.gzipBody = gzip(asset.body);
+        if (asset.gzipBody.size() >= asset.body.size()) {
+            asset.gzipBody.clear();
+        } else {
+            asset.gzipEtag = makeEtag(asset.body, "-gz");
+        }
+
+        std::string name = entry.path().filename().string();
+        if (name == "index.html") assets["/"] = asset;
+        assets["/" + name] = std::move(asset);
+    }
+    return assets.size();
+}
+
+const Asset* AssetCache::find(const std::string& url) const {
+    auto it = assets.find(url);
+    return it == assets.end() ? nullptr : &it->second;
+}
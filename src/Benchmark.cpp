@@ -0,0 +1,410 @@
+#include "../include/Game.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+// Микробенчмарки горячих путей движка: время и число выделений памяти на операцию
+// для выстрелов, стратегий, расстановки, проверки конца партии и сохранения.
+// Размер поля и плотность флота перебираются по сетке.
+
+namespace {
+
+std::atomic<uint64_t> allocations{0};
+// результаты замеряемых вызовов, чтобы оптимизатор их не выбросил
+volatile uint64_t sink = 0;
+
+} // namespace
+
+// считаем выделения во всех потоках, включая пул Монте-Карло
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    std::string filter;
+    double budget = 0.2;
+    uint64_t maxSize = UINT64_MAX;
+};
+
+struct BenchCase {
+    uint64_t size;
+    uint64_t ships[4];
+};
+
+struct Measurement {
+    double nanos = 0;
+    uint64_t allocs = 0;
+    uint64_t ops = 0;
+};
+
+const uint64_t SEED = 42;
+const uint64_t MAX_SHOTS = 4096;
+const char* const STRATEGIES[] = {"ordered", "custom", "density", "montecarlo"};
+
+double elapsedNanos(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+// флот классических пропорций 4:3:2:1, занимающий около density площади;
+// количество кораблей одного типа ограничено 255
+BenchCase makeCase(uint64_t size, double density) {
+    long double cells = static_cast<long double>(size) * size * density;
+    uint64_t sets = std::max<long double>(1, std::min<long double>(cells / 20, 255));
+    BenchCase result{size, {}};
+    for (int i = 0; i < 4; ++i) {
+        result.ships[i] = std::min<uint64_t>(sets * (4 - i), 255);
+    }
+    return result;
+}
+
+std::string caseName(const std::string& bench, const BenchCase& c) {
+    return bench + "/" + std::to_string(c.size) + "x" + std::to_string(c.size) + "/" +
+           std::to_string(c.ships[0]) + "-" + std::to_string(c.ships[1]) + "-" +
+           std::to_string(c.ships[2]) + "-" + std::to_string(c.ships[3]);
+}
+
+bool setupGame(Game& game, const BenchCase& c, const std::string& strategy) {
+    game.createGame("slave");
+    if (!game.setWidth(c.size) || !game.setHeight(c.size)) return false;
+    for (int size = 1; size <= 4; ++size) {
+        if (!game.setShipCount(size, c.ships[size - 1])) return false;
+    }
+    game.setSeed(SEED);
+    return game.setStrategy(strategy);
+}
+
+// на тесных полях генератор иногда сдаётся - пробуем другое зерно
+bool startWithNewSeed(Game& game, std::mt19937_64& gen) {
+    for (int attempt = 0; attempt < 8; ++attempt) {
+        game.setSeed(gen());
+        if (game.startGame()) return true;
+    }
+    return false;
+}
+
+// все клетки с кораблями и случайные пустые, без повторов, в случайном порядке
+std::vector<std::pair<uint64_t, uint64_t>> makeShots(const Board& board, std::mt19937_64& gen) {
+    std::set<std::pair<uint64_t, uint64_t>> unique;
+    board.forEach(CellState::SHIP, [&](uint64_t x, uint64_t y) {
+        if (unique.size() < MAX_SHOTS / 2) unique.insert({x, y});
+    });
+    unsigned __int128 area = static_cast<unsigned __int128>(board.getWidth()) * board.getHeight();
+    uint64_t target = static_cast<uint64_t>(std::min<unsigned __int128>(area, MAX_SHOTS));
+    std::uniform_int_distribution<uint64_t> column(0, board.getWidth() - 1);
+    std::uniform_int_distribution<uint64_t> row(0, board.getHeight() - 1);
+    while (unique.size() < target) {
+        unique.insert({column(gen), row(gen)});
+    }
+    std::vector<std::pair<uint64_t, uint64_t>> shots(unique.begin(), unique.end());
+    std::shuffle(shots.begin(), shots.end(), gen);
+    return shots;
+}
+
+// prepare() не замеряется и готовит очередную пачку, run() замеряет её и возвращает число операций
+template <typename Prepare, typename Run>
+Measurement measure(const BenchConfig& config, Prepare prepare, Run run) {
+    Measurement m;
+    auto start = Clock::now();
+    do {
+        if (!prepare()) break;
+        uint64_t allocsBefore = allocations.load(std::memory_order_relaxed);
+        auto batchStart = Clock::now();
+        uint64_t ops = run();
+        m.nanos += elapsedNanos(batchStart);
+        m.allocs += allocations.load(std::memory_order_relaxed) - allocsBefore;
+        m.ops += ops;
+    } while (elapsedNanos(start) < config.budget * 1e9);
+    return m;
+}
+
+void report(const std::string& name, const Measurement& m) {
+    if (m.ops == 0) {
+        std::cout << std::left << std::setw(64) << name << " skipped" << std::endl;
+        return;
+    }
+    std::cout << std::left << std::setw(64) << name << std::right
+              << std::fixed << std::setprecision(1)
+              << std::setw(14) << m.nanos / m.ops << " ns/op"
+              << std::setprecision(2)
+              << std::setw(10) << static_cast<double>(m.allocs) / m.ops << " allocs/op"
+              << std::setw(10) << m.ops << " ops" << std::endl;
+}
+
+bool selected(const BenchConfig& config, const std::string& name) {
+    return config.filter.empty() || name.find(config.filter) != std::string::npos;
+}
+
+void benchPlacement(const BenchConfig& config, const BenchCase& c) {
+    std::string name = caseName("generateRandomShipPlacement", c);
+    if (!selected(config, name)) return;
+    Game game;
+    bool ready = setupGame(game, c, "ordered");
+    report(name, measure(config,
+        [&] { return ready; },
+        [&] {
+            sink = static_cast<uint64_t>(game.generateRandomShipPlacement());
+            return uint64_t(1);
+        }));
+}
+
+// processShot - по флоту противника, processEnemyShot - по своему
+void benchShots(const BenchConfig& config, const BenchCase& c, bool enemy, bool journaled = false) {
+    std::string name = caseName(std::string(enemy ? "processEnemyShot" : "processShot") + (journaled ? "+journal" : ""), c);
+    if (!selected(config, name)) return;
+    Game game;
+    std::string journalPath = (std::filesystem::temp_directory_path() / "sea_battle_bench").string();
+    if (journaled && !game.openJournal(journalPath)) return report(name, Measurement());
+    if (!setupGame(game, c, "ordered")) return report(name, Measurement());
+    std::mt19937_64 gen(SEED);
+    std::vector<std::pair<uint64_t, uint64_t>> shots;
+    report(name, measure(config,
+        [&] {
+            if (!startWithNewSeed(game, gen)) return false;
+            shots = makeShots(enemy ? game.getPlayerBoard() : game.getEnemyBoard(), gen);
+            return true;
+        },
+        [&] {
+            for (const auto& [x, y] : shots) {
+                if (enemy) {
+                    game.processEnemyShot(x, y);
+                } else {
+                    game.processShot(x, y);
+                }
+            }
+            return static_cast<uint64_t>(shots.size());
+        }));
+    if (!journaled) return;
+    game.closeJournal();
+    std::remove((journalPath + ".snap").c_str());
+    std::remove((journalPath + ".journal").c_str());
+}
+
+// пробные выстрелы после mark и откат всей пачки; op - выстрел вместе с его откатом
+void benchSpeculate(const BenchConfig& config, const BenchCase& c) {
+    std::string name = caseName("processShot+undo", c);
+    if (!selected(config, name)) return;
+    Game game;
+    if (!setupGame(game, c, "ordered")) return report(name, Measurement());
+    std::mt19937_64 gen(SEED);
+    std::vector<std::pair<uint64_t, uint64_t>> shots;
+    report(name, measure(config,
+        [&] {
+            if (!startWithNewSeed(game, gen)) return false;
+            shots = makeShots(game.getEnemyBoard(), gen);
+            return true;
+        },
+        [&] {
+            // доска после отката та же, пачку можно прогнать несколько раз
+            const uint64_t ROUNDS = 8;
+            for (uint64_t round = 0; round < ROUNDS; ++round) {
+                UndoPoint point = game.mark();
+                for (const auto& [x, y] : shots) {
+                    game.processShot(x, y);
+                }
+                game.undo(point);
+            }
+            return static_cast<uint64_t>(shots.size()) * ROUNDS;
+        }));
+}
+
+// замеряется только выбор клетки, обработка выстрела идёт вне замера
+void benchStrategy(const BenchConfig& config, const BenchCase& c, const std::string& strategy) {
+    std::string name = caseName("getNextShot/" + strategy, c);
+    if (!selected(config, name)) return;
+    Game game;
+    if (!setupGame(game, c, strategy)) return report(name, Measurement());
+    std::mt19937_64 gen(SEED);
+
+    Measurement m;
+    auto start = Clock::now();
+    do {
+        if (!startWithNewSeed(game, gen)) break;
+        for (uint64_t shot = 0; shot < MAX_SHOTS && !game.isFinished(); ++shot) {
+            uint64_t allocsBefore = allocations.load(std::memory_order_relaxed);
+            auto shotStart = Clock::now();
+            auto [x, y] = game.getNextShot();
+            m.nanos += elapsedNanos(shotStart);
+            m.allocs += allocations.load(std::memory_order_relaxed) - allocsBefore;
+            ++m.ops;
+            if (game.processEnemyShot(x, y) == ShootResult::INVALID) break;
+            if (elapsedNanos(start) > config.budget * 1e9) break;
+        }
+    } while (elapsedNanos(start) < config.budget * 1e9);
+    report(name, m);
+}
+
+void benchFinished(const BenchConfig& config, const BenchCase& c) {
+    std::string name = caseName("isFinished", c);
+    if (!selected(config, name)) return;
+    Game game;
+    std::mt19937_64 gen(SEED);
+    bool ready = setupGame(game, c, "ordered") && startWithNewSeed(game, gen);
+    uint64_t finished = 0;
+    report(name, measure(config,
+        [&] { return ready; },
+        [&] {
+            const uint64_t CALLS = 100000;
+            for (uint64_t i = 0; i < CALLS; ++i) {
+                finished += game.isFinished();
+            }
+            return CALLS;
+        }));
+    sink = finished;
+}
+
+void benchSaveLoad(const BenchConfig& config, const BenchCase& c) {
+    std::string saveName = caseName("saveToFile", c);
+    std::string loadName = caseName("loadFromFile", c);
+    bool save = selected(config, saveName);
+    bool load = selected(config, loadName);
+    if (!save && !load) return;
+
+    std::string path = (std::filesystem::temp_directory_path() / "sea_battle_bench.txt").string();
+    Game game;
+    std::mt19937_64 gen(SEED);
+    bool ready = setupGame(game, c, "ordered") && startWithNewSeed(game, gen) && game.saveToFile(path);
+    if (save) {
+        report(saveName, measure(config,
+            [&] { return ready; },
+            [&] { return uint64_t(game.saveToFile(path)); }));
+    }
+    if (load) {
+        Game loaded;
+        report(loadName, measure(config,
+            [&] { return ready; },
+            [&] { return uint64_t(loaded.loadFromFile(path)); }));
+    }
+    std::remove(path.c_str());
+}
+
+void benchSnapshot(const BenchConfig& config, const BenchCase& c) {
+    std::string writeName = caseName("writeSnapshot", c);
+    std::string readName = caseName("readSnapshot", c);
+    std::string loadName = caseName("loadSnapshot", c);
+    bool write = selected(config, writeName);
+    bool read = selected(config, readName);
+    bool load = selected(config, loadName);
+    if (!write && !read && !load) return;
+
+    std::string path = (std::filesystem::temp_directory_path() / "sea_battle_bench.snap").string();
+    Game game;
+    std::mt19937_64 gen(SEED);
+    std::string buffer;
+    bool ready = setupGame(game, c, "ordered") && startWithNewSeed(game, gen) && game.saveSnapshot(path);
+    game.writeSnapshot(buffer);
+    if (write) {
+        report(writeName, measure(config,
+            [&] { return ready; },
+            [&] { game.writeSnapshot(buffer); return uint64_t(1); }));
+    }
+    Game restored;
+    if (read) {
+        report(readName, measure(config,
+            [&] { return ready; },
+            [&] { return uint64_t(restored.readSnapshot(buffer.data(), buffer.size())); }));
+    }
+    if (load) {
+        report(loadName, measure(config,
+            [&] { return ready; },
+            [&] { return uint64_t(restored.loadSnapshot(path)); }));
+    }
+    std::remove(path.c_str());
+}
+
+void printUsage() {
+    std::cerr << "Usage: benchmark [filter] [--time <seconds per benchmark>] [--max-size <n>]\n"
+              << "Filter is a substring of the benchmark name, e.g. getNextShot/density or /100x100/\n";
+}
+
+bool parseArgs(int argc, char** argv, BenchConfig& config) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        char* end = nullptr;
+        if (arg == "--time" && i + 1 < argc) {
+            config.budget = std::strtod(argv[++i], &end);
+            if (*end != '\0' || config.budget <= 0) return false;
+        } else if (arg == "--max-size" && i + 1 < argc) {
+            config.maxSize = std::strtoull(argv[++i], &end, 10);
+            if (*end != '\0') return false;
+        } else if (config.filter.empty() && arg.rfind("--", 0) != 0) {
+            config.filter = arg;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchConfig config;
+    if (!parseArgs(argc, argv, config)) {
+        printUsage();
+        return 1;
+    }
+    // 1000x1000 - самое большое плотное поле, дальше разреженные
+    const uint64_t SIZES[] = {10, 32, 100, 316, 1000, 100000, 1000000000};
+    const double DENSITIES[] = {0.01, 0.2};
+
+    for (uint64_t size : SIZES) {
+        if (size > config.maxSize) continue;
+        std::vector<BenchCase> cases;
+        for (double density : DENSITIES) {
+            BenchCase c = makeCase(size, density);
+            // на маленьких полях обе плотности дают один и тот же флот
+            if (!cases.empty() && std::equal(std::begin(c.ships), std::end(c.ships), cases.back().ships)) continue;
+            cases.push_back(c);
+        }
+        for (const auto& c : cases) {
+            benchPlacement(config, c);
+            benchShots(config, c, false);
+            benchShots(config, c, true);
+            benchShots(config, c, false, true);
+            benchSpeculate(config, c);
+            for (const char* strategy : STRATEGIES) {
+                benchStrategy(config, c, strategy);
+            }
+            benchFinished(config, c);
+            benchSaveLoad(config, c);
+            benchSnapshot(config, c);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,305 @@
+#include "../include/Board.hpp"
+#include <algorithm>
+#include <cstring>
+
+Board::Board()
+    : width(0)
+    , height(0)
+    , sparse(false)
+    , wordsPerRow(0)
+    , planeWords(0)
+    , tailMask(0)
+{
+}
+
+Board::Board(uint64_t w, uint64_t h) : Board() {
+    reset(w, h);
+}
+
+void Board::reset(uint64_t w, uint64_t h) {
+    if (w == 0 || h == 0) {
+        w = 0;
+        h = 0;
+    }
+    width = w;
+    height = h;
+    sparse = !fitsDense(w, h);
+    tiles.clear();
+    sparseShipIds.clear();
+
+    if (sparse) {
+        wordsPerRow = 0;
+        planeWords = 0;
+        tailMask = 0;
+        bits.clear();
+        bits.shrink_to_fit();
+        shipIds.clear();
+        shipIds.shrink_to_fit();
+        return;
+    }
+
+    wordsPerRow = (width + 63) / 64;
+    planeWords = wordsPerRow * height;
+    tailMask = (width % 64) ? (uint64_t(1) << (width % 64)) - 1 : ~uint64_t(0);
+    // assign переиспользует уже выделенную память
+    bits.assign(planeWords * PLANE_COUNT, 0);
+    shipIds.assign(width * height, 0);
+}
+
+void Board::clear() {
+    std::fill(bits.begin(), bits.end(), 0);
+    std::fill(shipIds.begin(), shipIds.end(), 0);
+    tiles.clear();
+    sparseShipIds.clear();
+}
+
+uint64_t Board::rangeMask(uint64_t from, uint64_t to) {
+    // биты [from, to] внутри одного слова
+    uint64_t high = (to == 63) ? ~uint64_t(0) : (uint64_t(1) << (to + 1)) - 1;
+    return high & ~((uint64_t(1) << from) - 1);
+}
+
+CellState Board::decode(const uint64_t* planes, uint64_t stride, uint64_t word, uint64_t bit) {
+    if ((planes[MISS_PLANE * stride + word] >> bit) & 1) return CellState::MISS;
+    if ((planes[KILL_PLANE * stride + word] >> bit) & 1) return CellState::KILL;
+    if ((planes[HIT_PLANE * stride + word] >> bit) & 1) return CellState::HIT;
+    if ((planes[SHIP_PLANE * stride + word] >> bit) & 1) return CellState::SHIP;
+    return CellState::EMPTY;
+}
+
+uint64_t Board::stateMask(const uint64_t* planes, uint64_t stride, uint64_t word, CellState state) {
+    uint64_t ship = planes[SHIP_PLANE * stride + word];
+    uint64_t hit = planes[HIT_PLANE * stride + word];
+    uint64_t miss = planes[MISS_PLANE * stride + word];
+    uint64_t kill = planes[KILL_PLANE * stride + word];
+    switch (state) {
+        case CellState::EMPTY: return ~(ship | miss);
+        case CellState::SHIP: return ship & ~hit;
+        case CellState::HIT: return hit & ~kill;
+        case CellState::MISS: return miss;
+        case CellState::KILL: return kill;
+    }
+    return 0;
+}
+
+void Board::setMask(uint64_t* planes, uint64_t stride, uint64_t word, uint64_t mask, CellState state) {
+    for (int p = 0; p < PLANE_COUNT; ++p) {
+        planes[p * stride + word] &= ~mask;
+    }
+    switch (state) {
+        case CellState::EMPTY:
+            break;
+        case CellState::KILL:
+            planes[KILL_PLANE * stride + word] |= mask;
+            [[fallthrough]];
+        case CellState::HIT:
+            planes[HIT_PLANE * stride + word] |= mask;
+            [[fallthrough]];
+        case CellState::SHIP:
+            planes[SHIP_PLANE * stride + word] |= mask;
+            break;
+        case CellState::MISS:
+            planes[MISS_PLANE * stride + word] |= mask;
+            break;
+    }
+}
+
+uint64_t Board::stateWord(uint64_t word, CellState state) const {
+    uint64_t mask = stateMask(bits.data(), planeWords, word, state);
+    if (state == CellState::EMPTY && word % wordsPerRow == wordsPerRow - 1) {
+        mask &= tailMask;
+    }
+    return mask;
+}
+
+CellState Board::getSparse(uint64_t x, uint64_t y) const {
+    auto it = tiles.find({x >> 3, y >> 3});
+    if (it == tiles.end()) return CellState::EMPTY;
+    return decode(it->second.planes, 1, 0, (y & 7) * 8 + (x & 7));
+}
+
+void Board::setSparse(uint64_t x, uint64_t y, CellState state) {
+    auto it = tiles.find({x >> 3, y >> 3});
+    if (it == tiles.end()) {
+        // пустую клетку в пустой плитке записывать незачем
+        if (state == CellState::EMPTY) return;
+        it = tiles.emplace(CellKey{x >> 3, y >> 3}, Tile()).first;
+    }
+    setMask(it->second.planes, 1, 0, uint64_t(1) << ((y & 7) * 8 + (x & 7)), state);
+}
+
+uint16_t Board::getShipId(uint64_t x, uint64_t y) const {
+    if (!sparse) return shipIds[y * width + x];
+    auto it = sparseShipIds.find({x, y});
+    return it == sparseShipIds.end() ? 0 : it->second;
+}
+
+void Board::setShipId(uint64_t x, uint64_t y, uint16_t id) {
+    if (!sparse) {
+        shipIds[y * width + x] = id;
+    } else if (id == 0) {
+        sparseShipIds.erase({x, y});
+    } else {
+        sparseShipIds[{x, y}] = id;
+    }
+}
+
+bool Board::clipRect(uint64_t& x0, uint64_t& y0, uint64_t& x1, uint64_t& y1) const {
+    if (empty()) return false;
+    // после обрезки x1 < width, поэтому циклы до x1 включительно не переполняются
+    x1 = std::min(x1, width - 1);
+    y1 = std::min(y1, height - 1);
+    return x0 <= x1 && y0 <= y1;
+}
+
+bool Board::anyInRect(uint64_t x0, uint64_t y0, uint64_t x1, uint64_t y1, CellState state) const {
+    if (!clipRect(x0, y0, x1, y1)) return false;
+
+    if (sparse) {
+        // прямоугольники в игре - корабль с ореолом, поклеточно быстрее поиска плиток
+        for (uint64_t y = y0; y <= y1; ++y) {
+            for (uint64_t x = x0; x <= x1; ++x) {
+                if (getSparse(x, y) == state) return true;
+            }
+        }
+        return false;
+    }
+
+    uint64_t firstWord = x0 >> 6;
+    uint64_t lastWord = x1 >> 6;
+    for (uint64_t y = y0; y <= y1; ++y) {
+        uint64_t row = y * wordsPerRow;
+        for (uint64_t w = firstWord; w <= lastWord; ++w) {
+            uint64_t mask = rangeMask(w == firstWord ? (x0 & 63) : 0,
+                                      w == lastWord ? (x1 & 63) : 63);
+            if (stateWord(row + w, state) & mask) return true;
+        }
+    }
+    return false;
+}
+
+void Board::fillRect(uint64_t x0, uint64_t y0, uint64_t x1, uint64_t y1, CellState state) {
+    if (!clipRect(x0, y0, x1, y1)) return;
+
+    if (sparse) {
+        for (uint64_t y = y0; y <= y1; ++y) {
+            for (uint64_t x = x0; x <= x1; ++x) {
+                setSparse(x, y, state);
+            }
+        }
+        return;
+    }
+
+    uint64_t firstWord = x0 >> 6;
+    uint64_t lastWord = x1 >> 6;
+    for (uint64_t y = y0; y <= y1; ++y) {
+        uint64_t row = y * wordsPerRow;
+        for (uint64_t w = firstWord; w <= lastWord; ++w) {
+            setWord(row + w, rangeMask(w == firstWord ? (x0 & 63) : 0,
+                                       w == lastWord ? (x1 & 63) : 63), state);
+        }
+    }
+}
+
+void Board::fillEmptyInRect(uint64_t x0, uint64_t y0, uint64_t x1, uint64_t y1, CellState state) {
+    if (!clipRect(x0, y0, x1, y1)) return;
+
+    if (sparse) {
+        for (uint64_t y = y0; y <= y1; ++y) {
+            for (uint64_t x = x0; x <= x1; ++x) {
+                if (getSparse(x, y) == CellState::EMPTY) setSparse(x, y, state);
+            }
+        }
+        return;
+    }
+
+    uint64_t firstWord = x0 >> 6;
+    uint64_t lastWord = x1 >> 6;
+    for (uint64_t y = y0; y <= y1; ++y) {
+        uint64_t row = y * wordsPerRow;
+        for (uint64_t w = firstWord; w <= lastWord; ++w) {
+            uint64_t mask = rangeMask(w == firstWord ? (x0 & 63) : 0,
+                                      w == lastWord ? (x1 & 63) : 63);
+            mask &= stateWord(row + w, CellState::EMPTY);
+            if (mask) setWord(row + w, mask, state);
+        }
+    }
+}
+
+uint64_t Board::count(CellState state) const {
+    uint64_t total = 0;
+    if (sparse) {
+        if (state == CellState::EMPTY) {
+            // пустые клетки не хранятся; площадь может не влезть в uint64_t
+            uint64_t used = 0;
+            for (CellState other : {CellState::SHIP, CellState::HIT, CellState::MISS, CellState::KILL}) {
+                used += count(other);
+            }
+            return (height > UINT64_MAX / width) ? UINT64_MAX : width * height - used;
+        }
+        for (const auto& [key, tile] : tiles) {
+            total += __builtin_popcountll(stateMask(tile.planes, 1, 0, state));
+        }
+        return total;
+    }
+    for (uint64_t w = 0; w < planeWords; ++w) {
+        total += __builtin_popcountll(stateWord(w, state));
+    }
+    return total;
+}
+
+uint64_t Board::packedWords() const {
+    return sparse ? tiles.size() * TILE_WORDS : bits.size();
+}
+
+void Board::pack(unsigned char* out) const {
+    if (!sparse) {
+        if (!bits.empty()) std::memcpy(out, bits.data(), bits.size() * sizeof(uint64_t));
+        return;
+    }
+    for (const auto& [key, tile] : tiles) {
+        uint64_t words[TILE_WORDS] = {key.x, key.y};
+        std::memcpy(words + 2, tile.planes, sizeof(tile.planes));
+        std::memcpy(out, words, sizeof(words));
+        out += sizeof(words);
+    }
+}
+
+bool Board::checkPacked(uint64_t w, uint64_t h, const unsigned char* words, uint64_t count) {
+    if (w == 0 || h == 0) return count == 0;
+    if (fitsDense(w, h)) return count == (w + 63) / 64 * h * PLANE_COUNT;
+    if (count % TILE_WORDS) return false;
+    for (uint64_t i = 0; i < count; i += TILE_WORDS) {
+        uint64_t key[2];
+        std::memcpy(key, words + i * sizeof(uint64_t), sizeof(key));
+        if (key[0] > (w - 1) / 8 || key[1] > (h - 1) / 8) return false;
+    }
+    return true;
+}
+
+void Board::unpack(const unsigned char* words, uint64_t count) {
+    if (!sparse) {
+        if (bits.empty()) return;
+        std::memcpy(bits.data(), words, bits.size() * sizeof(uint64_t));
+        // хвост последнего слова строки за правым краем поля должен быть пуст
+        for (int p = 0; p < PLANE_COUNT; ++p) {
+            for (uint64_t y = 0; y < height; ++y) {
+                bits[p * planeWords + y * wordsPerRow + wordsPerRow - 1] &= tailMask;
+            }
+        }
+        return;
+    }
+    tiles.reserve(count / TILE_WORDS);
+    for (uint64_t i = 0; i < count; i += TILE_WORDS) {
+        uint64_t record[TILE_WORDS];
+        std::memcpy(record, words + i * sizeof(uint64_t), sizeof(record));
+        // у крайних плиток часть клеток лежит за полем
+        uint64_t columns = std::min<uint64_t>(8, width - record[0] * 8);
+        uint64_t rows = std::min<uint64_t>(8, height - record[1] * 8);
+        uint64_t row = columns == 8 ? 0xFF : (uint64_t(1) << columns) - 1;
+        uint64_t mask = 0;
+        for (uint64_t r = 0; r < rows; ++r) mask |= row << (r * 8);
+        Tile& tile = tiles[{record[0], record[1]}];
+        for (int p = 0; p < PLANE_COUNT; ++p) tile.planes[p] = record[2 + p] & mask;
+    }
+}
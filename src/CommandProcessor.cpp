@@ -1,210 +1,492 @@
 #include "../include/CommandProcessor.hpp"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
-#include <sstream>
+#include <vector>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
-CommandProcessor::CommandProcessor(Game& game) : game(game) {}
+namespace {
+
+constexpr size_t VERB_SLOTS = 32;
+constexpr uint8_t NO_VERB = 0xff;
+
+// Совершенный хеш для этого набора слов: длина, первая и последняя буквы
+// дают каждому слову свой слот, так что разбор - одно сравнение строк.
+constexpr size_t verbSlot(std::string_view verb) {
+    return (verb.size() + 17u * static_cast<unsigned char>(verb.front()) +
+            13u * static_cast<unsigned char>(verb.back())) & (VERB_SLOTS - 1);
+}
+
+struct VerbTable {
+    uint8_t slots[VERB_SLOTS];
+};
+
+constexpr VerbTable makeVerbTable() {
+    VerbTable table{};
+    for (size_t slot = 0; slot < VERB_SLOTS; ++slot) table.slots[slot] = NO_VERB;
+    for (size_t i = 0; i < CommandProcessor::VERB_COUNT; ++i) {
+        // совпадение слотов не даст вычислить таблицу при компиляции
+        if (table.slots[verbSlot(CommandProcessor::VERBS[i])] != NO_VERB) throw "verbSlot collision";
+        table.slots[verbSlot(CommandProcessor::VERBS[i])] = static_cast<uint8_t>(i);
+    }
+    return table;
+}
+
+constexpr VerbTable VERB_TABLE = makeVerbTable();
+
+const char* yesNo(bool value) {
+    return value ? "yes" : "no";
+}
+
+const char* shotResultName(ShootResult result) {
+    switch (result) {
+        case ShootResult::MISS: return "miss";
+        case ShootResult::HIT: return "hit";
+        case ShootResult::KILL: return "kill";
+        default: return "failed";
+    }
+}
+
+// Строки stdin, прочитанные большими блоками. Перед чтением, которое может
+// заблокироваться, накопленный вывод сбрасывается: собеседник ждёт ответов,
+// а пока во входном буфере есть готовые строки, ответы копятся без сброса.
+class InputLines {
+private:
+    static const size_t BLOCK_SIZE = 64 * 1024;
+
+    std::vector<char> buffer = std::vector<char>(BLOCK_SIZE);
+    size_t begin = 0;
+    size_t end = 0;
+    bool eof = false;
+
+    long readBlock(char* data, size_t size) {
+        while (true) {
+#ifdef _WIN32
+            long count = _read(0, data, static_cast<unsigned>(size));
+#else
+            long count = ::read(STDIN_FILENO, data, size);
+#endif
+            if (count >= 0 || errno != EINTR) return count;
+        }
+    }
+
+public:
+    // строка без перевода строки; false, когда ввод кончился
+    bool next(std::string_view& line) {
+        while (true) {
+            const char* start = buffer.data() + begin;
+            if (const void* newline = std::memchr(start, '\n', end - begin)) {
+                size_t length = static_cast<const char*>(newline) - start;
+                begin += length + 1;
+                if (length && start[length - 1] == '\r') --length;
+                line = std::string_view(start, length);
+                return true;
+            }
+            if (eof) {
+                // последняя строка без перевода строки
+                if (begin == end) return false;
+                line = std::string_view(start, end - begin);
+                begin = end;
+                return true;
+            }
+
+            // неполную строку в начало буфера; строке длиннее буфера - буфер побольше
+            std::memmove(buffer.data(), start, end - begin);
+            end -= begin;
+            begin = 0;
+            if (end == buffer.size()) buffer.resize(buffer.size() * 2);
+
+            std::cout.flush();
+            long count = readBlock(buffer.data() + end, buffer.size() - end);
+            if (count <= 0) {
+                eof = true;
+            } else {
+                end += static_cast<size_t>(count);
+            }
+        }
+    }
+};
+
+} // namespace
+
+CommandProcessor::CommandProcessor(Game& game, ProcessorMode mode) : game(game), mode(mode) {
+    // в протоколе соперник - другой движок со своим флотом
+    if (protocol()) game.setRemoteOpponent(true);
+}
 
 void CommandProcessor::run() {
-    std::cout << "\nAvailable commands for game creation:\n";
-    std::cout << "create master/slave - create game in master/slave mode\n";
-    std::cout << "exit - exit the game\n\n";
+    // stdout сбрасывается только перед ожиданием ввода, а не после каждой строки
+    std::ios::sync_with_stdio(false);
+    std::cin.tie(nullptr);
+
+    if (verbose()) {
+        std::cout << "\nAvailable commands for game creation:\n";
+        std::cout << "create master/slave - create game in master/slave mode\n";
+        std::cout << "exit - exit the game\n\n";
+    }
 
-    std::string line;
-    while (std::getline(std::cin, line)) {
+    InputLines input;
+    std::string_view line;
+    while (input.next(line)) {
         std::string response = processCommand(line);
-        std::cout << response << std::endl;
-        
-        if (line == "exit") {
+        std::cout << response << '\n';
+
+        if (CommandTokens(line).next() == "exit") {
             break;
         }
     }
+    std::cout.flush();
+}
+
+CommandProcessor::Handler CommandProcessor::findHandler(std::string_view verb) {
+    static const Handler HANDLERS[] = {
+        &CommandProcessor::handleCreate, &CommandProcessor::handleStart, &CommandProcessor::handleShot,
+        &CommandProcessor::handleStop, &CommandProcessor::handleDisplay, &CommandProcessor::handleReveal,
+        &CommandProcessor::handleSet, &CommandProcessor::handlePlace, &CommandProcessor::handleSave,
+        &CommandProcessor::handleLoad, &CommandProcessor::handleExit, &CommandProcessor::handlePing,
+        &CommandProcessor::handleGet, &CommandProcessor::handleFinished, &CommandProcessor::handleWin,
+        &CommandProcessor::handleLose, &CommandProcessor::handleDump, &CommandProcessor::handleResult
+    };
+    static_assert(sizeof(HANDLERS) / sizeof(HANDLERS[0]) == VERB_COUNT, "one handler per verb");
+
+    size_t index = verbIndex(verb);
+    return index != VERB_COUNT ? HANDLERS[index] : nullptr;
+}
+
+size_t CommandProcessor::verbIndex(std::string_view verb) {
+    if (verb.empty()) return VERB_COUNT;
+    uint8_t index = VERB_TABLE.slots[verbSlot(verb)];
+    return index != NO_VERB && VERBS[index] == verb ? index : VERB_COUNT;
+}
+
+std::string CommandProcessor::processCommand(std::string_view command) {
+    CommandTokens tokens(command);
+    Handler handler = findHandler(tokens.next());
+    if (!handler) return protocol() ? "failed" : "Unknown command";
+    return (this->*handler)(tokens);
 }
 
-std::pair<std::string, std::string> CommandProcessor::parseCommand(const std::string& command) {
-    std::istringstream iss(command);
-    std::string cmd, args;
-    iss >> cmd;
-    std::getline(iss >> std::ws, args);
-    return {cmd, args};
+std::string CommandProcessor::reply(bool ok, const char* text) const {
+    if (protocol()) return ok ? "ok" : "failed";
+    return text;
 }
 
-std::string CommandProcessor::processCommand(const std::string& command) {
-    std::istringstream iss(command);
-    std::string cmd;
-    iss >> cmd;
-    std::string args;
-    std::getline(iss >> std::ws, args);
+void CommandProcessor::showBoards() const {
+    if (verbose()) game.displayBoards();
+}
 
-    if (cmd == "create") {
-        if (game.createGame(args)) {
+std::string CommandProcessor::handleCreate(CommandTokens& args) {
+    std::string mode(args.tail());
+    if (game.createGame(mode)) {
+        if (protocol()) return "ok";
+        if (verbose()) {
             std::cout << "\nGame configuration started! Available commands:\n";
             std::cout << "- set size <width> <height>  : Set board size (example: set size 10 10)\n";
             std::cout << "- set ships <size> <count>   : Set number of ships (example: set ships 4 1)\n";
-            std::cout << "- set strategy type      : Set strategy (ordered/random/custom)\n";
+            std::cout << "- set strategy type      : Set strategy (ordered/custom/density/montecarlo [threads samples])\n";
+            std::cout << "- set timelimit <ms>     : Limit time per enemy move, 0 - no limit\n";
             std::cout << "- start                  : Start the game\n\n";
-            return "Game mode set to " + args;
         }
-        return "Failed to set game mode";
+        return "Game mode set to " + mode;
     }
-    else if (cmd == "start") {
-        if (game.startGame()) {
-            game.displayBoards();
-            if (game.isCurrentTurn()) {
-                return "Your turn! Make a shot (shot x y)";
-            } else {
-                return makeEnemyShot(), "Enemy's turn!";
+    return reply(false, "Failed to set game mode");
+}
 
-            }
+std::string CommandProcessor::handleStart(CommandTokens&) {
+    if (verbose()) {
+        std::cout << "Starting game...\n";
+        std::cout << "Field size: " << game.getWidth() << "x" << game.getHeight() << '\n';
+        std::cout << "Ship counts: ";
+        for (int size = 1; size <= 4; ++size) {
+            std::cout << size << "-deck: " << game.getShipCount(size) << ", ";
         }
-        return "Failed to start game";
+        std::cout << '\n';
     }
-    else if (cmd == "shot") {
-        if (!game.isCurrentTurn()) {
-            return "Not your turn!";
+
+    if (game.startGame()) {
+        // в протоколе очерёдность ходов ведёт собеседник
+        if (protocol()) return "ok";
+        if (verbose()) {
+            std::cout << "\nGame started! Available commands:\n";
+            std::cout << "- shot x y     : Make a shot at coordinates (x,y)\n";
+            std::cout << "- save file    : Save the whole game to a binary snapshot\n";
+            std::cout << "- load file    : Load a snapshot or a dump file\n";
+            std::cout << "- display      : Show the game boards\n";
+            std::cout << "- reveal       : Show enemy ships (debug)\n";
+            std::cout << "- stop         : Stop the game\n\n";
+            std::cout << "- exit        : Exit the program\n\n";
         }
-        
-        std::istringstream iss(args);
-        uint64_t x, y;
-        if (!(iss >> x >> y)) {
-            return "Invalid shot format. Use: shot x y";
-        }
-        
-        if (!game.isValidPosition(x, y)) {
-            return "Invalid coordinates";
-        }
-        
-        ShootResult result = game.processShot(x, y);
-        game.displayBoards();
-        
-        switch (result) {
-            case ShootResult::MISS:
-                game.switchTurn();
-                return "Miss! " + makeEnemyShot();
-            case ShootResult::HIT:
-                return "Hit! Your turn again.";
-            case ShootResult::KILL:
-                if (game.isFinished()) {
-                    return "Ship destroyed! Game Over - You won!";
-                }
-                return "Ship destroyed! Your turn again.";
-            case ShootResult::INVALID:
-                return "Invalid shot";
-            default:
-                return "Unknown result";
+        showBoards();
+        if (game.isCurrentTurn()) {
+            return "Your turn! Make a shot (shot x y)";
+        } else {
+            return makeEnemyShot(), "Enemy's turn!";
+
         }
     }
-    else if (cmd == "stop") {
-        if (game.stopGame()) {
-            return "Game stopped";
+    if (protocol()) return "failed";
+    return "Failed to start game: " + game.getSetupError();
+}
+
+std::string CommandProcessor::handleShot(CommandTokens& args) {
+    if (protocol()) {
+        // shot без координат - только координаты нашего следующего выстрела,
+        // попадание по чужому полю знает лишь соперник и сообщает его командой result
+        CommandTokens coordinates = args;
+        if (coordinates.next().empty()) {
+            auto [x, y] = game.getNextShot();
+            lastShotX = x;
+            lastShotY = y;
+            shotPending = true;
+            return std::to_string(x) + " " + std::to_string(y);
         }
-        return "Failed to stop game";
+        // shot X Y - соперник стреляет по нашим кораблям
+        uint64_t x, y;
+        if (!args.number(x) || !args.number(y)) return "failed";
+        return shotResultName(game.processEnemyShot(x, y));
     }
-    else if (cmd == "display") {
-        game.displayBoards();
-        return "";
+
+    if (!game.isCurrentTurn()) {
+        return "Not your turn!";
     }
-    else if (cmd == "reveal") {
-        game.displayEnemyShips();
-        return "";
+
+    uint64_t x, y;
+    if (!args.number(x) || !args.number(y)) {
+        return "Invalid shot format. Use: shot x y";
     }
-    else if (cmd == "set") {
-        std::istringstream iss(args);
-        std::string param;
-        iss >> param;
 
-        if (param == "strategy") {
-            std::string strategy;
-            iss >> strategy;
-            return game.setStrategy(strategy) ? "Strategy set" : "Failed to set strategy";
-        }
-        else if (param == "size") {
-            uint64_t width, height;
-            if (!(iss >> width >> height)) {
-                return "Invalid size format. Use: set size <width> <height>";
-            }
-            if (width == 0 || height == 0) {
-                return "Width and height must be greater than 0";
-            }
-            if (width > 100 || height > 100) {
-                return "Width and height must be less than or equal to 100";
-            }
-            
-            game.resetBoards();
-            
-            if (!game.setWidth(width)) {
-                return "Failed to set width";
-            }
-            if (!game.setHeight(height)) {
-                return "Failed to set height";
-            }
-            
-            return "Board size set to " + std::to_string(width) + "x" + std::to_string(height);
-        }
-        else if (param == "ships") {
-            int size;
-            uint64_t count;
-            if (!(iss >> size >> count)) {
-                return "Invalid ships format. Use: set ships <size> <count>";
-            }
-            if (size < 1 || size > 4) {
-                return "Ship size must be between 1 and 4";
-            }
-            if (count > 10) {
-                return "Too many ships of one type (max 10)";
+    if (!game.isValidPosition(x, y)) {
+        return "Invalid coordinates";
+    }
+
+    ShootResult result = game.processShot(x, y);
+    showBoards();
+
+    switch (result) {
+        case ShootResult::MISS:
+            game.switchTurn();
+            return "Miss! " + makeEnemyShot();
+        case ShootResult::HIT:
+            return "Hit! Your turn again.";
+        case ShootResult::KILL:
+            if (game.isFinished()) {
+                return "Ship destroyed! Game Over - You won!";
             }
-            if (!game.setShipCount(size, count)) {
-                return "Failed to set ship count. Game might have already started.";
+            return "Ship destroyed! Your turn again.";
+        case ShootResult::INVALID:
+            return "Invalid shot";
+        default:
+            return "Unknown result";
+    }
+}
+
+std::string CommandProcessor::handleStop(CommandTokens&) {
+    bool stopped = game.stopGame();
+    return reply(stopped, stopped ? "Game stopped" : "Failed to stop game");
+}
+
+std::string CommandProcessor::handleDisplay(CommandTokens&) {
+    showBoards();
+    return "";
+}
+
+std::string CommandProcessor::handleReveal(CommandTokens&) {
+    if (verbose()) game.displayEnemyShips();
+    return "";
+}
+
+std::string CommandProcessor::handleSet(CommandTokens& args) {
+    std::string_view param = args.next();
+
+    if (param == "strategy") {
+        std::string strategy(args.next());
+        if (strategy == "montecarlo") {
+            // set strategy montecarlo [threads samples]: либо без параметров, либо оба
+            std::string_view options = args.tail();
+            if (!options.empty()) {
+                CommandTokens numbers(options);
+                uint64_t threads, samples;
+                if (!numbers.number(threads) || !numbers.number(samples) || !numbers.next().empty() ||
+                    !game.setMonteCarloOptions(threads, samples)) {
+                    return reply(false, "Invalid Monte Carlo options. Use: set strategy montecarlo [<threads> <samples>]");
+                }
             }
-            return "Set " + std::to_string(count) + " ships of size " + std::to_string(size);
         }
-        return "Invalid set command";
+        bool set = game.setStrategy(strategy);
+        return reply(set, set ? "Strategy set" : "Failed to set strategy");
+    }
+    else if (param == "timelimit") {
+        uint64_t milliseconds;
+        if (!args.number(milliseconds)) {
+            return reply(false, "Invalid time limit format. Use: set timelimit <ms>");
+        }
+        if (!game.setTimeLimit(milliseconds)) {
+            return reply(false, "Time limit is too large");
+        }
+        if (protocol()) return "ok";
+        if (milliseconds == 0) return "Time limit removed";
+        return "Time limit set to " + std::to_string(milliseconds) + " ms";
+    }
+    else if (param == "size") {
+        uint64_t width, height;
+        if (!args.number(width) || !args.number(height)) {
+            return reply(false, "Invalid size format. Use: set size <width> <height>");
+        }
+        if (width == 0 || height == 0) {
+            return reply(false, "Width and height must be greater than 0");
+        }
+
+        if (!game.setWidth(width)) {
+            return reply(false, "Failed to set width");
+        }
+        if (!game.setHeight(height)) {
+            return reply(false, "Failed to set height");
+        }
+
+        if (protocol()) return "ok";
+        return "Board size set to " + std::to_string(width) + "x" + std::to_string(height);
     }
-    else if (cmd == "place") {
-        std::istringstream iss(args);
-        int x, y, size;
-        std::string direction;
-        
-        if (!(iss >> x >> y >> size >> direction)) {
-            return "Usage: place x y size direction(h/v)";
+    else if (param == "width" || param == "height") {
+        // set width N / set height N из README
+        uint64_t value;
+        if (!args.number(value) || value == 0) {
+            return reply(false, "Size must be a positive number");
         }
-        
-        if (x < 0 || x >= 10 || y < 0 || y >= 10) {
-            return "Invalid coordinates. Must be between 0 and 9";
+        bool set = param == "width" ? game.setWidth(value) : game.setHeight(value);
+        if (!set) return reply(false, "Failed to set size. Game might have already started.");
+        if (protocol()) return "ok";
+        return "Board " + std::string(param) + " set to " + std::to_string(value);
+    }
+    else if (param == "ships" || param == "count") {
+        // set count <size> N из README - то же, что set ships
+        int size;
+        uint64_t count;
+        if (!args.number(size) || !args.number(count)) {
+            return reply(false, "Invalid ships format. Use: set ships <size> <count>");
         }
-        
         if (size < 1 || size > 4) {
-            return "Invalid ship size. Must be between 1 and 4";
-        }
-        
-        bool horizontal = (direction == "h" || direction == "H");
-        
-        if (game.placeShip(x, y, size, horizontal)) {
-            game.displayBoards();
-            return "Ship placed successfully";
-        } else {
-            return "Cannot place ship here. Check size and overlapping";
+            return reply(false, "Ship size must be between 1 and 4");
+        }
+        if (count > 10) {
+            return reply(false, "Too many ships of one type (max 10)");
         }
+        if (!game.setShipCount(size, count)) {
+            return reply(false, "Failed to set ship count. Game might have already started.");
+        }
+        if (protocol()) return "ok";
+        return "Set " + std::to_string(count) + " ships of size " + std::to_string(size);
     }
-    else if (cmd == "save") {
-        return game.saveToFile(args) ? "Game saved" : "Failed to save game";
+    return reply(false, "Invalid set command");
+}
+
+std::string CommandProcessor::handlePlace(CommandTokens& args) {
+    uint64_t x, y;
+    int size;
+    if (!args.number(x) || !args.number(y) || !args.number(size)) {
+        return reply(false, "Usage: place x y size direction(h/v)");
+    }
+    std::string_view direction = args.next();
+    if (direction.empty()) {
+        return reply(false, "Usage: place x y size direction(h/v)");
+    }
+
+    if (x >= game.getWidth() || y >= game.getHeight()) {
+        if (protocol()) return "failed";
+        return "Invalid coordinates. Must be below " + std::to_string(game.getWidth()) + " and " +
+               std::to_string(game.getHeight());
+    }
+
+    if (size < 1 || size > 4) {
+        return reply(false, "Invalid ship size. Must be between 1 and 4");
+    }
+
+    bool horizontal = (direction == "h" || direction == "H");
+
+    if (game.placeShip(x, y, size, horizontal)) {
+        showBoards();
+        return reply(true, "Ship placed successfully");
+    } else {
+        return reply(false, "Cannot place ship here. Check size and overlapping");
     }
-    else if (cmd == "load") {
-        return game.loadFromFile(args) ? "Game loaded" : "Failed to load game";
+}
+
+// save - бинарный снимок всей партии, dump - текстовая расстановка из README
+std::string CommandProcessor::handleSave(CommandTokens& args) {
+    bool saved = game.saveSnapshot(std::string(args.tail()));
+    return reply(saved, saved ? "Game saved" : "Failed to save game");
+}
+
+std::string CommandProcessor::handleLoad(CommandTokens& args) {
+    bool loaded = game.loadFromFile(std::string(args.tail()));
+    return reply(loaded, loaded ? "Game loaded" : "Failed to load game");
+}
+
+std::string CommandProcessor::handleExit(CommandTokens&) {
+    return reply(true, "Goodbye!");
+}
+
+std::string CommandProcessor::handlePing(CommandTokens&) {
+    return "pong";
+}
+
+std::string CommandProcessor::handleGet(CommandTokens& args) {
+    std::string_view param = args.next();
+    if (param == "width") return std::to_string(game.getWidth());
+    if (param == "height") return std::to_string(game.getHeight());
+    if (param == "count") {
+        int size;
+        if (!args.number(size) || size < 1 || size > 4) {
+            return reply(false, "Ship size must be between 1 and 4");
+        }
+        return std::to_string(game.getShipCount(size));
     }
-    else if (cmd == "exit") {
-        return "Goodbye!";
+    return reply(false, "Invalid get command");
+}
+
+std::string CommandProcessor::handleFinished(CommandTokens&) {
+    return yesNo(game.isFinished());
+}
+
+std::string CommandProcessor::handleWin(CommandTokens&) {
+    return yesNo(game.isWinner());
+}
+
+std::string CommandProcessor::handleLose(CommandTokens&) {
+    return yesNo(game.isLoser());
+}
+
+// dump - сохранение под именем из протокола README, файл читается командой load
+std::string CommandProcessor::handleDump(CommandTokens& args) {
+    return game.saveToFile(std::string(args.tail())) ? "ok" : "failed";
+}
+
+// result miss|hit|kill - исход нашего последнего shot по полю соперника
+std::string CommandProcessor::handleResult(CommandTokens& args) {
+    std::string_view word = args.next();
+    ShootResult result = word == "miss" ? ShootResult::MISS
+                       : word == "hit"  ? ShootResult::HIT
+                       : word == "kill" ? ShootResult::KILL
+                                        : ShootResult::INVALID;
+    if (result == ShootResult::INVALID) return reply(false, "Usage: result miss|hit|kill");
+    if (!shotPending || !game.applyShotResult(lastShotX, lastShotY, result)) {
+        return reply(false, "No engine shot is waiting for a result");
     }
-    
-    return "Unknown command";
+    shotPending = false;
+    return reply(true, "Result recorded");
 }
 
 std::string CommandProcessor::makeEnemyShot() {
     auto [x, y] = game.getNextShot();
     ShootResult result = game.processEnemyShot(x, y);
-    game.displayBoards();
-    
+    showBoards();
+
     std::string resultStr = "Enemy shot at (" + std::to_string(x) + "," + std::to_string(y) + "): ";
-    
+
     switch (result) {
         case ShootResult::MISS:
             game.switchTurn();
@@ -0,0 +1,57 @@
+#include "../include/CustomStrategy.hpp"
+#include "../include/Game.hpp"
+#include <algorithm>
+
+bool CustomStrategy::isUnknown(const Board& board, uint64_t x, uint64_t y) {
+    if (x >= board.getWidth() || y >= board.getHeight()) return false;
+    CellState state = board.get(x, y);
+    return state == CellState::EMPTY || state == CellState::SHIP;
+}
+
+void CustomStrategy::reset(const Board& board, const int aliveShips[4], uint64_t seed) {
+    gen.seed(seed);
+    hits.clear();
+    board.forEach(CellState::HIT, [&](uint64_t x, uint64_t y) { hits.push_back({x, y}); });
+    fallback.reset(board, aliveShips, seed);
+}
+
+std::pair<uint64_t, uint64_t> CustomStrategy::nextShot(const Board& board, ShotDeadline deadline) {
+    if (board.empty()) return {0, 0};
+
+    while (!hits.empty()) {
+        auto [x, y] = hits.back();
+        // соседнее попадание задаёт ось корабля - её проверяем первой
+        bool vertical = board.get(x, y) == CellState::HIT &&
+                        ((y > 0 && board.get(x, y - 1) == CellState::HIT) ||
+                         (y + 1 < board.getHeight() && board.get(x, y + 1) == CellState::HIT));
+        const std::pair<int, int> horizontalFirst[] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+        const std::pair<int, int> verticalFirst[] = {{0, 1}, {0, -1}, {1, 0}, {-1, 0}};
+        for (const auto& [dx, dy] : vertical ? verticalFirst : horizontalFirst) {
+            // при выходе за 0 беззнаковая координата переполняется и отсекается isUnknown
+            uint64_t nx = x + dx;
+            uint64_t ny = y + dy;
+            if (isUnknown(board, nx, ny)) return {nx, ny};
+        }
+        hits.pop_back();
+    }
+
+    std::uniform_int_distribution<uint64_t> column(0, board.getWidth() - 1);
+    std::uniform_int_distribution<uint64_t> row(0, board.getHeight() - 1);
+    for (int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt) {
+        uint64_t x = column(gen);
+        uint64_t y = row(gen);
+        if ((x + y) % 2 == 0 && isUnknown(board, x, y)) return {x, y};
+    }
+    // шахматные клетки почти кончились - добираем по порядку
+    return fallback.nextShot(board, deadline);
+}
+
+void CustomStrategy::onShot(uint64_t x, uint64_t y, ShootResult result, const Ship* killed) {
+    if (result == ShootResult::HIT) {
+        hits.push_back({x, y});
+    } else if (result == ShootResult::KILL && killed) {
+        hits.erase(std::remove_if(hits.begin(), hits.end(), [&](const auto& hit) {
+            return killed->containsPosition(hit.first, hit.second);
+        }), hits.end());
+    }
+}
@@ -0,0 +1,282 @@
+#include "../include/DensityStrategy.hpp"
+#include "../include/Game.hpp"
+#include <algorithm>
+
+void DensityStrategy::reset(const Board& board, const int aliveShips[4], uint64_t) {
+    width = board.getWidth();
+    height = board.getHeight();
+    std::copy(aliveShips, aliveShips + 4, alive);
+    awaitingResult = false;
+    hits.clear();
+
+    uint64_t total = width * height;
+    cells.assign(total, UNKNOWN);
+    placements.assign(4 * total, 0);
+    // пока веса нулевые, addPlacement их не трогает - они считаются после счётчиков
+    scores.assign(total, 0);
+    words = (total + 63) / 64;
+    summaryWords = (words + 63) / 64;
+    bucketCells.assign((MAX_SCORE + 1) * words, 0);
+    bucketWords.assign((MAX_SCORE + 1) * summaryWords, 0);
+    std::fill(std::begin(bucketSize), std::end(bucketSize), 0);
+
+    // SHIP для стреляющего не виден и считается неизвестной клеткой
+    board.forEach(CellState::MISS, [&](uint64_t x, uint64_t y) { cells[y * width + x] = BLOCKED; });
+    board.forEach(CellState::KILL, [&](uint64_t x, uint64_t y) { cells[y * width + x] = BLOCKED; });
+    board.forEach(CellState::HIT, [&](uint64_t x, uint64_t y) {
+        cells[y * width + x] = HIT;
+        hits.push_back(y * width + x);
+    });
+
+    for (int size = 1; size <= 4; ++size) {
+        for (uint64_t y = 0; y < height; ++y) {
+            for (uint64_t x = 0; x < width; ++x) {
+                if (isFree(x, y, size, true)) addPlacement(x, y, size, true, 1);
+                if (size > 1 && isFree(x, y, size, false)) addPlacement(x, y, size, false, 1);
+            }
+        }
+    }
+
+    for (uint64_t cell = 0; cell < total; ++cell) {
+        if (cells[cell] != UNKNOWN) continue;
+        int score = 1;
+        for (int size = 1; size <= 4; ++size) {
+            if (alive[size - 1] > 0) score += placements[cell * 4 + size - 1];
+        }
+        setScore(cell, score);
+    }
+}
+
+bool DensityStrategy::isFree(uint64_t x, uint64_t y, int size, bool horizontal) const {
+    if (horizontal ? x + size > width : y + size > height) return false;
+    uint64_t step = horizontal ? 1 : width;
+    uint64_t cell = y * width + x;
+    for (int i = 0; i < size; ++i, cell += step) {
+        if (cells[cell] == BLOCKED) return false;
+    }
+    return true;
+}
+
+void DensityStrategy::addPlacement(uint64_t x, uint64_t y, int size, bool horizontal, int delta) {
+    uint64_t step = horizontal ? 1 : width;
+    uint64_t cell = y * width + x;
+    bool counted = alive[size - 1] > 0;
+    for (int i = 0; i < size; ++i, cell += step) {
+        placements[cell * 4 + size - 1] += delta;
+        // вес есть только у неизвестных клеток
+        if (counted && scores[cell]) setScore(cell, scores[cell] + delta);
+    }
+}
+
+void DensityStrategy::setScore(uint64_t cell, int score) {
+    uint64_t word = cell >> 6;
+    uint64_t bit = uint64_t(1) << (cell & 63);
+    int old = scores[cell];
+    if (old) {
+        uint64_t& bits = bucketCells[old * words + word];
+        bits &= ~bit;
+        if (!bits) bucketWords[old * summaryWords + (word >> 6)] &= ~(uint64_t(1) << (word & 63));
+        --bucketSize[old];
+    }
+    if (score) {
+        bucketCells[score * words + word] |= bit;
+        bucketWords[score * summaryWords + (word >> 6)] |= uint64_t(1) << (word & 63);
+        ++bucketSize[score];
+    }
+    scores[cell] = static_cast<uint8_t>(score);
+}
+
+uint64_t DensityStrategy::bestCell() const {
+    int score = MAX_SCORE;
+    while (score > 0 && bucketSize[score] == 0) --score;
+    if (score == 0) return width * height;
+    const uint64_t* summary = bucketWords.data() + score * summaryWords;
+    uint64_t i = 0;
+    while (!summary[i]) ++i;
+    uint64_t word = i * 64 + __builtin_ctzll(summary[i]);
+    return word * 64 + __builtin_ctzll(bucketCells[score * words + word]);
+}
+
+void DensityStrategy::block(uint64_t x, uint64_t y) {
+    uint64_t cell = y * width + x;
+    if (cells[cell] == BLOCKED) return;
+
+    // снимаем все ещё допустимые расстановки, проходящие через клетку
+    for (int size = 1; size <= 4; ++size) {
+        for (int dir = 0; dir < (size > 1 ? 2 : 1); ++dir) {
+            bool horizontal = dir == 0;
+            uint64_t pos = horizontal ? x : y;
+            for (int k = 0; k < size && static_cast<uint64_t>(k) <= pos; ++k) {
+                uint64_t startX = horizontal ? x - k : x;
+                uint64_t startY = horizontal ? y : y - k;
+                if (isFree(startX, startY, size, horizontal)) {
+                    addPlacement(startX, startY, size, horizontal, -1);
+                }
+            }
+        }
+    }
+    cells[cell] = BLOCKED;
+    setScore(cell, 0);
+}
+
+bool DensityStrategy::findTargetShot(uint64_t& best) const {
+    // группа попаданий, связанная с первым раненым кораблём; корабли не касаются,
+    // так что это палубы одного корабля и их не больше четырёх
+    uint64_t group[4] = {hits.front()};
+    int groupSize = 1;
+    for (int i = 0; i < groupSize; ++i) {
+        uint64_t cell = group[i];
+        uint64_t x = cell % width;
+        uint64_t y = cell / width;
+        uint64_t neighbours[4];
+        int count = 0;
+        if (x > 0) neighbours[count++] = cell - 1;
+        if (x + 1 < width) neighbours[count++] = cell + 1;
+        if (y > 0) neighbours[count++] = cell - width;
+        if (y + 1 < height) neighbours[count++] = cell + width;
+        for (int n = 0; n < count; ++n) {
+            if (cells[neighbours[n]] != HIT || std::find(group, group + groupSize, neighbours[n]) != group + groupSize) {
+                continue;
+            }
+            if (groupSize == 4) return false;
+            group[groupSize++] = neighbours[n];
+        }
+    }
+
+    uint64_t minX = width, minY = height, maxX = 0, maxY = 0;
+    for (int i = 0; i < groupSize; ++i) {
+        minX = std::min(minX, group[i] % width);
+        maxX = std::max(maxX, group[i] % width);
+        minY = std::min(minY, group[i] / width);
+        maxY = std::max(maxY, group[i] / width);
+    }
+    if (minX != maxX && minY != maxY) return false;
+    int groupLength = static_cast<int>(std::max(maxX - minX, maxY - minY) + 1);
+
+    // расстановки через группу лежат на её строке или столбце не дальше трёх клеток
+    // от краёв группы: окно из 7 клеток на направление
+    uint64_t scored[2][8] = {};
+    uint64_t base[2] = {maxX >= 3 ? maxX - 3 : 0, maxY >= 3 ? maxY - 3 : 0};
+    for (int size = groupLength; size <= 4; ++size) {
+        if (alive[size - 1] <= 0) continue;
+        for (int dir = 0; dir < 2; ++dir) {
+            bool horizontal = dir == 0;
+            if (groupLength > 1 && horizontal != (minY == maxY)) continue;
+            if (size == 1 && !horizontal) continue;
+
+            // расстановка должна накрывать всю группу [from, to]
+            uint64_t from = horizontal ? minX : minY;
+            uint64_t to = horizontal ? maxX : maxY;
+            uint64_t lowest = (to + 1 >= static_cast<uint64_t>(size)) ? to + 1 - size : 0;
+            for (uint64_t start = lowest; start <= from; ++start) {
+                uint64_t startX = horizontal ? start : minX;
+                uint64_t startY = horizontal ? minY : start;
+                if (!isFree(startX, startY, size, horizontal)) continue;
+
+                uint64_t endX = horizontal ? startX + size - 1 : startX;
+                uint64_t endY = horizontal ? startY : startY + size - 1;
+
+                // чужие попадания в ореоле означают касание кораблей
+                bool touches = false;
+                for (uint64_t cy = (startY ? startY - 1 : 0); cy <= std::min(endY + 1, height - 1) && !touches; ++cy) {
+                    for (uint64_t cx = (startX ? startX - 1 : 0); cx <= std::min(endX + 1, width - 1); ++cx) {
+                        bool inside = cx >= startX && cx <= endX && cy >= startY && cy <= endY;
+                        if (!inside && cells[cy * width + cx] == HIT) {
+                            touches = true;
+                            break;
+                        }
+                    }
+                }
+                if (touches) continue;
+
+                for (int i = 0; i < size; ++i) {
+                    uint64_t cell = horizontal ? startY * width + startX + i : (startY + i) * width + startX;
+                    if (cells[cell] == UNKNOWN) scored[dir][start + i - base[dir]] += alive[size - 1];
+                }
+            }
+        }
+    }
+
+    // при равенстве - клетка с меньшим номером
+    uint64_t bestScore = 0;
+    for (int dir = 0; dir < 2; ++dir) {
+        for (uint64_t i = 0; i < 8; ++i) {
+            if (!scored[dir][i]) continue;
+            uint64_t cell = dir == 0 ? minY * width + base[0] + i : (base[1] + i) * width + minX;
+            if (scored[dir][i] > bestScore || (scored[dir][i] == bestScore && cell < best)) {
+                bestScore = scored[dir][i];
+                best = cell;
+            }
+        }
+    }
+    return bestScore > 0;
+}
+
+std::pair<uint64_t, uint64_t> DensityStrategy::nextShot(const Board&, ShotDeadline) {
+    if (width == 0 || height == 0) return {0, 0};
+
+    // ответа на прошлый выстрел не было - результат неизвестен, счётчики не трогаем
+    if (awaitingResult && cells[lastShot] == UNKNOWN) {
+        cells[lastShot] = PENDING;
+        setScore(lastShot, 0);
+    }
+
+    uint64_t total = width * height;
+    uint64_t best = total;
+    if (hits.empty() || !findTargetShot(best)) best = bestCell();
+
+    if (best == total) return {0, 0};
+    awaitingResult = true;
+    lastShot = best;
+    return {best % width, best / width};
+}
+
+void DensityStrategy::onShot(uint64_t x, uint64_t y, ShootResult result, const Ship* killed) {
+    if (x >= width || y >= height) return;
+    awaitingResult = false;
+    uint64_t cell = y * width + x;
+
+    switch (result) {
+        case ShootResult::MISS:
+            block(x, y);
+            break;
+        case ShootResult::HIT:
+            if (cells[cell] == UNKNOWN || cells[cell] == PENDING) {
+                cells[cell] = HIT;
+                setScore(cell, 0);
+                hits.push_back(cell);
+            }
+            break;
+        case ShootResult::KILL: {
+            if (!killed) {
+                block(x, y);
+                break;
+            }
+            int size = killed->getSize();
+            if (alive[size - 1] > 0 && --alive[size - 1] == 0) {
+                // тип кончился: его счётчики уходят из весов всех клеток, не чаще
+                // четырёх раз за партию
+                for (uint64_t c = 0; c < width * height; ++c) {
+                    if (scores[c] && placements[c * 4 + size - 1]) setScore(c, scores[c] - placements[c * 4 + size - 1]);
+                }
+            }
+            hits.erase(std::remove_if(hits.begin(), hits.end(), [&](uint64_t h) {
+                return killed->containsPosition(h % width, h / width);
+            }), hits.end());
+
+            // корабль и ореол вокруг него
+            uint64_t fromX = killed->getX() ? killed->getX() - 1 : 0;
+            uint64_t fromY = killed->getY() ? killed->getY() - 1 : 0;
+            uint64_t toX = std::min(killed->getEndX() + 1, width - 1);
+            uint64_t toY = std::min(killed->getEndY() + 1, height - 1);
+            for (uint64_t cy = fromY; cy <= toY; ++cy) {
+                for (uint64_t cx = fromX; cx <= toX; ++cx) {
+                    block(cx, cy);
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
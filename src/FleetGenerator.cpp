@@ -0,0 +1,288 @@
+#include "../include/FleetGenerator.hpp"
+#include "../include/Board.hpp"
+#include "../include/Metrics.hpp"
+#include <algorithm>
+#include <cmath>
+
+void FleetGenerator::resize(uint64_t w, uint64_t h) {
+    width = w;
+    height = h;
+    wordsPerRow = (width + 63) / 64;
+    tailMask = (width % 64) ? (uint64_t(1) << (width % 64)) - 1 : ~uint64_t(0);
+    occupied.assign(wordsPerRow * height, 0);
+    cover.assign(width * height, 0);
+}
+
+uint64_t FleetGenerator::freeWord(uint64_t y, uint64_t word) const {
+    uint64_t valid = (word == wordsPerRow - 1) ? tailMask : ~uint64_t(0);
+    return ~occupied[y * wordsPerRow + word] & valid;
+}
+
+uint64_t FleetGenerator::occupy(const Ship& ship, int delta) {
+    uint64_t fromX = ship.getX() ? ship.getX() - 1 : 0;
+    uint64_t fromY = ship.getY() ? ship.getY() - 1 : 0;
+    uint64_t toX = std::min(ship.getEndX() + 1, width - 1);
+    uint64_t toY = std::min(ship.getEndY() + 1, height - 1);
+    uint64_t taken = 0;
+    for (uint64_t y = fromY; y <= toY; ++y) {
+        for (uint64_t x = fromX; x <= toX; ++x) {
+            uint8_t& count = cover[y * width + x];
+            uint64_t& word = occupied[y * wordsPerRow + (x >> 6)];
+            uint64_t bit = uint64_t(1) << (x & 63);
+            taken += count == 0;
+            if (delta > 0 && count++ == 0) word |= bit;
+            if (delta < 0 && --count == 0) word &= ~bit;
+        }
+    }
+    return taken;
+}
+
+uint64_t FleetGenerator::anchorWord(int size, bool horizontal, uint64_t y, uint64_t word) const {
+    uint64_t mask = freeWord(y, word);
+    if (horizontal) {
+        // бит x остаётся, если свободны клетки x..x+size-1
+        uint64_t next = (word + 1 < wordsPerRow) ? freeWord(y, word + 1) : 0;
+        uint64_t current = mask;
+        for (int k = 1; k < size && mask; ++k) {
+            mask &= (current >> k) | (next << (64 - k));
+        }
+    } else {
+        // пересечение size подряд идущих строк
+        for (int k = 1; k < size && mask; ++k) {
+            mask &= freeWord(y + k, word);
+        }
+    }
+    return mask;
+}
+
+uint64_t FleetGenerator::keyCount(int size) const {
+    // ключ = (направление * height + y) * width + x; однопалубным вертикаль не нужна
+    return (size > 1 ? 2 : 1) * height * width;
+}
+
+bool FleetGenerator::selectAnchor(int size, uint64_t from, uint64_t index, uint64_t& key, uint64_t& count) const {
+    // деление только на входе, дальше обход по строкам и словам
+    uint64_t plane = height * width;
+    count = 0;
+    uint64_t dir = from / plane;
+    uint64_t y = (from % plane) / width;
+    uint64_t x = from % width;
+    for (; dir < (size > 1 ? 2u : 1u); ++dir, y = 0, x = 0) {
+        bool horizontal = dir == 0;
+        uint64_t rows = horizontal ? height : (static_cast<uint64_t>(size) > height ? 0 : height - size + 1);
+        for (; y < rows; ++y, x = 0) {
+            for (uint64_t word = x >> 6; word < wordsPerRow; ++word) {
+                uint64_t mask = anchorWord(size, horizontal, y, word);
+                if (word == x >> 6) mask &= ~uint64_t(0) << (x & 63);
+                uint64_t bits = __builtin_popcountll(mask);
+                if (index >= bits) {
+                    index -= bits;
+                    count += bits;
+                    continue;
+                }
+                while (index--) mask &= mask - 1;
+                key = dir * plane + y * width + word * 64 + __builtin_ctzll(mask);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool FleetGenerator::isAnchor(int size, uint64_t key) const {
+    uint64_t plane = height * width;
+    bool horizontal = key < plane;
+    uint64_t y = (key % plane) / width;
+    uint64_t x = key % width;
+    if (!horizontal && y + size > height) return false;
+    return (anchorWord(size, horizontal, y, x >> 6) >> (x & 63)) & 1;
+}
+
+bool FleetGenerator::findAnchor(int size, uint64_t from, uint64_t to, uint64_t& key) const {
+    uint64_t count;
+    return from < to && selectAnchor(size, from, 0, key, count) && key < to;
+}
+
+bool FleetGenerator::nextAnchor(int size, Level& level, uint64_t& key) const {
+    if (!level.wrapped) {
+        if (findAnchor(size, level.cursor, keyCount(size), key)) {
+            level.cursor = key + 1;
+            return true;
+        }
+        level.wrapped = true;
+        level.cursor = level.low;
+    }
+    if (!findAnchor(size, level.cursor, level.start, key)) return false;
+    level.cursor = key + 1;
+    return true;
+}
+
+Ship FleetGenerator::shipAt(int size, uint64_t key) const {
+    uint64_t plane = height * width;
+    return Ship(key % width, (key % plane) / width, size, key < plane);
+}
+
+bool FleetGenerator::mayFit(uint64_t w, uint64_t h, const std::vector<uint8_t>& shipCounts) {
+    // корабль с правой и нижней полосой ореола занимает (size + 1) x 2 клеток
+    // на поле (w + 1) x (h + 1), и такие прямоугольники не пересекаются
+    // (w + 1) * (h + 1) - 1 помещается в 128 бит при любых w и h
+    unsigned __int128 area = static_cast<unsigned __int128>(w) * h + w + h;
+    unsigned __int128 needed = 0;
+    for (size_t i = 0; i < shipCounts.size(); ++i) {
+        uint64_t size = i + 1;
+        if (shipCounts[i] > 0 && size > std::max(w, h)) return false;
+        needed += static_cast<unsigned __int128>(shipCounts[i]) * (size + 1) * 2;
+    }
+    return needed == 0 || needed - 1 <= area;
+}
+
+bool FleetGenerator::touches(const Ship& a, const Ship& b) {
+    // корабли пересекаются или соприкасаются, если ореол одного задевает другой
+    return a.getX() <= b.getEndX() + 1 && b.getX() <= a.getEndX() + 1 &&
+           a.getY() <= b.getEndY() + 1 && b.getY() <= a.getEndY() + 1;
+}
+
+PlacementResult FleetGenerator::generateSparse(uint64_t w, uint64_t h, const std::vector<int>& sizes,
+                                               std::mt19937_64& gen, std::vector<Ship>& ships) {
+    // маску на всё поле не завести, но флот занимает ничтожную долю клеток:
+    // случайные позиции почти всегда свободны
+    for (int size : sizes) {
+        bool canHorizontal = static_cast<uint64_t>(size) <= w;
+        bool canVertical = static_cast<uint64_t>(size) <= h;
+        bool placed = false;
+        for (int attempt = 0; attempt < MAX_SPARSE_ATTEMPTS && !placed; ++attempt) {
+            METRIC_ADD(Counter::PLACEMENT_ATTEMPTS, 1);
+            bool horizontal = canHorizontal && (!canVertical || (gen() & 1));
+            uint64_t maxX = horizontal ? w - size : w - 1;
+            uint64_t maxY = horizontal ? h - 1 : h - size;
+            uint64_t x = std::uniform_int_distribution<uint64_t>(0, maxX)(gen);
+            uint64_t y = std::uniform_int_distribution<uint64_t>(0, maxY)(gen);
+            Ship ship(x, y, size, horizontal);
+            if (std::none_of(ships.begin(), ships.end(), [&](const Ship& other) { return touches(ship, other); })) {
+                ships.push_back(ship);
+                placed = true;
+            }
+        }
+        if (!placed) {
+            ships.clear();
+            return PlacementResult::GAVE_UP;
+        }
+    }
+    return PlacementResult::OK;
+}
+
+uint64_t FleetGenerator::luby(uint64_t i) {
+    // 1 1 2 1 1 2 4 1 1 2 1 1 2 4 8 ...
+    uint64_t k = 1;
+    while ((uint64_t(1) << k) - 1 < i) ++k;
+    while ((uint64_t(1) << k) - 1 != i) {
+        i -= (uint64_t(1) << (k - 1)) - 1;
+        k = 1;
+        while ((uint64_t(1) << k) - 1 < i) ++k;
+    }
+    return uint64_t(1) << (k - 1);
+}
+
+PlacementResult FleetGenerator::generate(uint64_t w, uint64_t h, const std::vector<uint8_t>& shipCounts,
+                                         std::mt19937_64& gen, std::vector<Ship>& ships) {
+    ships.clear();
+    if (w == 0 || h == 0 || !mayFit(w, h, shipCounts)) return PlacementResult::INFEASIBLE;
+
+    std::vector<int> sizes;
+    for (int size = static_cast<int>(shipCounts.size()); size > 0; --size) {
+        sizes.insert(sizes.end(), shipCounts[size - 1], size);
+    }
+    if (sizes.empty()) return PlacementResult::OK;
+    if (!Board::fitsDense(w, h)) return generateSparse(w, h, sizes, gen, ships);
+
+    levels.resize(sizes.size());
+    chosen.resize(sizes.size());
+    // свободных клеток перед каждым уровнем и клеток, нужных оставшимся кораблям
+    freeCells.resize(sizes.size());
+    cellsLeft.assign(sizes.size() + 1, 0);
+    for (size_t i = sizes.size(); i-- > 0;) {
+        cellsLeft[i] = cellsLeft[i + 1] + sizes[i];
+    }
+    ships.reserve(sizes.size());
+    unsigned __int128 area = static_cast<unsigned __int128>(w) * h;
+    uint64_t budget = static_cast<uint64_t>(std::max<unsigned __int128>(area * NODES_PER_CELL, MIN_NODES));
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    auto enter = [&](size_t depth) {
+        // одинаковые корабли - по возрастанию ключа
+        Level& level = levels[depth];
+        level.low = depth > 0 && sizes[depth] == sizes[depth - 1] ? chosen[depth - 1] + 1 : 0;
+        uint64_t keys = keyCount(sizes[depth]);
+        // старт - минимум из m равномерно выбранных якорей, где m - сколько кораблей
+        // этого размера ещё ставить: упорядоченные якоря распределены как отсортированные
+        // независимые, и группа не сбивается к концу ключей
+        size_t m = 1;
+        while (depth + m < sizes.size() && sizes[depth + m] == sizes[depth]) ++m;
+        auto quantile = [&] { return 1.0 - std::pow(unit(gen), 1.0 / m); };
+        level.start = keys;
+        if (level.low < keys) {
+            // на большом поле случайный ключ обычно сам допустим; иначе точный
+            // выбор по номеру среди всех якорей, два прохода по полю
+            bool found = false;
+            int probes = keys - level.low >= MIN_PROBED_KEYS ? ANCHOR_PROBES : 0;
+            for (int attempt = 0; attempt < probes && !found; ++attempt) {
+                uint64_t key = level.low + static_cast<uint64_t>(quantile() * static_cast<double>(keys - level.low));
+                found = key < keys && isAnchor(sizes[depth], key);
+                if (found) level.start = key;
+            }
+            uint64_t anchors = 0;
+            if (!found && !selectAnchor(sizes[depth], level.low, UINT64_MAX, level.start, anchors) && anchors) {
+                uint64_t rank = static_cast<uint64_t>(quantile() * static_cast<double>(anchors));
+                selectAnchor(sizes[depth], level.low, std::min(rank, anchors - 1), level.start, anchors);
+            }
+        }
+        level.cursor = level.start;
+        level.wrapped = false;
+    };
+
+    // Неудачный перебор обычно застревает на последних мелких кораблях, и возврат
+    // к ним почти не помогает: перезапуск дешевле. Первые перезапуски короткие,
+    // каждый следующий вдвое длиннее, пока не кончится бюджет
+    uint64_t spent = 0;
+    for (uint64_t restart = 1; spent < budget; ++restart) {
+        uint64_t nodesPerRestart = std::min(luby(restart) * RESTART_NODES_PER_SHIP * sizes.size(), budget - spent);
+        resize(w, h);
+        ships.clear();
+        size_t depth = 0;
+        uint64_t nodes = 0;
+        freeCells[0] = w * h;
+        enter(0);
+
+        while (depth < sizes.size()) {
+            uint64_t key;
+            if (!nextAnchor(sizes[depth], levels[depth], key)) {
+                // на первом уровне варианты кончились - перебор полный, расстановки нет
+                if (depth == 0) return PlacementResult::INFEASIBLE;
+                --depth;
+                occupy(ships.back(), -1);
+                ships.pop_back();
+                continue;
+            }
+            if (++nodes > nodesPerRestart) break;
+            METRIC_ADD(Counter::PLACEMENT_ATTEMPTS, 1);
+
+            // палубы оставшихся кораблей должны поместиться в свободные клетки
+            Ship ship = shipAt(sizes[depth], key);
+            uint64_t left = freeCells[depth] - occupy(ship, 0);
+            if (left < cellsLeft[depth + 1]) continue;
+
+            chosen[depth] = key;
+            ships.push_back(ship);
+            occupy(ship, 1);
+            if (++depth < sizes.size()) {
+                freeCells[depth] = left;
+                enter(depth);
+            }
+        }
+
+        if (depth == sizes.size()) return PlacementResult::OK;
+        spent += nodesPerRestart;
+    }
+
+    ships.clear();
+    return PlacementResult::GAVE_UP;
+}
@@ -1,4 +1,6 @@
 #include "../include/Game.hpp"
+#include "../include/GameSnapshot.hpp"
+#include "../include/Metrics.hpp"
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -11,6 +13,7 @@ Game::Game()
     , width(0)
     , height(0)
     , shipCounts(4, 0)
+    , rng(std::random_device{}())
     , gameStarted(false)
     , myTurn(false)
 {
@@ -18,6 +21,7 @@ Game::Game()
 }
 
 bool Game::createGame(const std::string& mode) {
+    if (speculating) return false;
     //master
     if (mode == "master") {
         this->mode = GameMode::MASTER;
@@ -41,135 +45,85 @@ bool Game::createGame(const std::string& mode) {
     }
 
     initializeBoards();
-    
+    if (journal) checkpoint();
     return true;
 }
 
 bool Game::setStrategy(const std::string& strategy) {
+    if (speculating) return false;
     if (strategy == "ordered") {
         currentStrategy = Strategy::ORDERED;
-        return true;
     } else if (strategy == "custom") {
         currentStrategy = Strategy::CUSTOM;
-        return true;
+    } else if (strategy == "density") {
+        currentStrategy = Strategy::DENSITY;
+    } else if (strategy == "montecarlo") {
+        currentStrategy = Strategy::MONTE_CARLO;
+    } else {
+        return false;
     }
-    return false;
+    // новая стратегия собирает знание с текущей доски
+    resetStrategy();
+    // зерно идёт в поле x записи, см. Game::replay
+    journalEvent(JournalEvent::SET_STRATEGY, strategySeed, 0, static_cast<uint8_t>(currentStrategy));
+    return true;
+}
+
+bool Game::setMonteCarloOptions(uint64_t threads, uint64_t samples) {
+    if (threads == 0 || samples == 0 || speculating) return false;
+    monteCarloStrategy.configure(threads, samples);
+    journalEvent(JournalEvent::SET_MONTE_CARLO, threads, samples);
+    return true;
+}
+
+bool Game::setTimeLimit(uint64_t milliseconds) {
+    if (milliseconds > MAX_TIME_LIMIT || speculating) return false;
+    timeLimit = milliseconds;
+    journalEvent(JournalEvent::SET_TIME_LIMIT, milliseconds);
+    return true;
 }
 
 bool Game::setShipCount(int shipSize, uint64_t count) {
-    if (shipSize < 1 || shipSize > 4 || gameStarted) return false;
+    if (shipSize < 1 || shipSize > 4 || count > MAX_SHIP_COUNT || gameStarted || speculating) return false;
     
-    shipCounts[shipSize - 1] = count;
+    shipCounts[shipSize - 1] = static_cast<uint8_t>(count);
 
     myShips.clear();
     enemyShips.clear();
     initializeBoards();
-    
+    journalEvent(JournalEvent::SET_SHIP_COUNT, count, 0, static_cast<uint8_t>(shipSize));
     return true;
 }
 
-void Game::generateRandomShipPlacement() {
-    std::cout << "Starting ship placement..." << std::endl;
-    
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<uint64_t> disW(0, width - 1);
-    std::uniform_int_distribution<uint64_t> disH(0, height - 1);
-    std::bernoulli_distribution disDir(0.5);
-
-    myShips.clear();
-    enemyShips.clear();
+PlacementResult Game::generateRandomShipPlacement() {
+    if (speculating) return PlacementResult::GAVE_UP;
     initializeBoards();
 
-    for (size_t size = 4; size > 0; --size) {
-        uint8_t count = shipCounts[size - 1];
-        if (count == 0) continue;
-        
-        int attempts = 0;
-        const int MAX_ATTEMPTS = 100; // попытка на оптимизацию
-
-        while (count > 0 && attempts < MAX_ATTEMPTS) {
-            uint64_t x = disW(gen);
-            uint64_t y = disH(gen);
-            bool horizontal = disDir(gen);
-            
-            if (horizontal && x + size > width) continue;
-            if (!horizontal && y + size > height) continue;
-            
-            if (canPlaceShip(x, y, size, horizontal)) {
-                Ship newShip(x, y, size, horizontal);
-                if (isValidPlacement(newShip)) {
-                    myShips.push_back(newShip);
-                    if (horizontal) {
-                        for (int i = 0; i < size; ++i) {
-                            myBoard[y][x + i] = CellState::SHIP;
-                        }
-                    } else {
-                        for (int i = 0; i < size; ++i) {
-                            myBoard[y + i][x] = CellState::SHIP;
-                        }
-                    }
-                    --count;
-                    attempts = 0;
-                }
-            }
-            ++attempts;
-        }
-        
-        if (count > 0) {
-            myShips.clear();
-            enemyShips.clear();
-            initializeBoards();
-            return;
-        }
+    std::vector<Ship> fleet;
+    PlacementResult result = fleetGenerator.generate(width, height, shipCounts, rng, fleet);
+    if (result != PlacementResult::OK) return result;
+    for (const auto& ship : fleet) {
+        addShip(ship, myShips, myBoard, myFleet);
+    }
+    // флот удалённого соперника расставляет он сам
+    if (remoteOpponent) {
+        enemyFleet = remoteFleet();
+        return PlacementResult::OK;
     }
 
-    for (size_t size = 4; size > 0; --size) {
-        uint8_t count = shipCounts[size - 1];
-        if (count == 0) continue;
-        
-        int attempts = 0;
-        const int MAX_ATTEMPTS = 100; // тоже попытка
-
-        while (count > 0 && attempts < MAX_ATTEMPTS) {
-            uint64_t x = disW(gen);
-            uint64_t y = disH(gen);
-            bool horizontal = disDir(gen);
-            
-            if (horizontal && x + size > width) continue;
-            if (!horizontal && y + size > height) continue;
-            
-            if (canPlaceEnemyShip(x, y, size, horizontal)) {
-                Ship newShip(x, y, size, horizontal);
-                if (isValidPlacement(newShip)) {
-                    enemyShips.push_back(newShip);
-                    if (horizontal) {
-                        for (int i = 0; i < size; ++i) {
-                            enemyBoard[y][x + i] = CellState::SHIP;
-                        }
-                    } else {
-                        for (int i = 0; i < size; ++i) {
-                            enemyBoard[y + i][x] = CellState::SHIP;
-                        }
-                    }
-                    --count;
-                    attempts = 0;
-                }
-            }
-            ++attempts;
-        }
-        
-        if (count > 0) {
-            myShips.clear();
-            enemyShips.clear();
-            initializeBoards();
-            return;
-        }
+    result = fleetGenerator.generate(width, height, shipCounts, rng, fleet);
+    if (result != PlacementResult::OK) {
+        initializeBoards();
+        return result;
     }
+    for (const auto& ship : fleet) {
+        addShip(ship, enemyShips, enemyBoard, enemyFleet);
+    }
+    return PlacementResult::OK;
 }
 
-bool Game::placeShip(int x, int y, int size, bool horizontal) {
-    if (!placementPhase || !canPlaceShip(size)) {
+bool Game::placeShip(uint64_t x, uint64_t y, int size, bool horizontal) {
+    if (!placementPhase || !canPlaceShip(size) || speculating) {
         return false;
     }
 
@@ -179,239 +133,219 @@ bool Game::placeShip(int x, int y, int size, bool horizontal) {
         return false;
     }
 
-    myShips.push_back(newShip);
+    addShip(newShip, myShips, myBoard, myFleet);
     remainingShips[size - 1]--;
     
     if (std::all_of(std::begin(remainingShips), std::end(remainingShips), 
                     [](int count) { return count == 0; })) {
         placementPhase = false;
     }
+    journalEvent(JournalEvent::PLACE_SHIP, x, y, static_cast<uint8_t>(size), horizontal);
+    return true;
+}
 
-    if (horizontal) {
-        for (int i = 0; i < size; ++i) {
-            myBoard[y][x + i] = CellState::SHIP;
-        }
-    } else {
-        for (int i = 0; i < size; ++i) {
-            myBoard[y + i][x] = CellState::SHIP;
-        }
+void Game::addShip(const Ship& ship, std::vector<Ship>& ships, Board& board, FleetStatus& fleet) {
+    markRebuilt();
+    ships.push_back(ship);
+    ++fleet.totalShips;
+    ++fleet.aliveShips;
+    fleet.aliveCells += ship.getSize();
+    uint16_t id = static_cast<uint16_t>(ships.size());
+    board.fillRect(ship.getX(), ship.getY(), ship.getEndX(), ship.getEndY(), CellState::SHIP);
+    for (uint64_t i = 0; i < ship.getSize(); ++i) {
+        board.setShipId(ship.isHorizontal() ? ship.getX() + i : ship.getX(),
+                        ship.isHorizontal() ? ship.getY() : ship.getY() + i, id);
     }
-
-    return true;
 }
 
 bool Game::canPlaceShip(uint64_t x, uint64_t y, int size, bool horizontal) const {
+    // x + size переполнилось бы у края uint64_t, поэтому сравнение с остатком
+    if (x >= width || y >= height) return false;
     if (horizontal) {
-        if (x + size > width) return false;
+        if (static_cast<uint64_t>(size) > width - x) return false;
     } else {
-        if (y + size > height) return false;
+        if (static_cast<uint64_t>(size) > height - y) return false;
     }
 
-    for (int i = -1; i <= size; i++) {
-        for (int j = -1; j <= 1; j++) {
-            uint64_t checkX = horizontal ? x + i : x + j;
-            uint64_t checkY = horizontal ? y + j : y + i;
-            
-            if (checkX >= width || checkY >= height) continue;
-            if (checkX == (uint64_t)-1 || checkY == (uint64_t)-1) continue;
+    // корабль вместе с ореолом в одну клетку
+    uint64_t endX = horizontal ? x + size - 1 : x;
+    uint64_t endY = horizontal ? y : y + size - 1;
+    return !myBoard.anyInRect(x ? x - 1 : 0, y ? y - 1 : 0,
+                              endX + 1, endY + 1, CellState::SHIP);
+}
 
-            if (myBoard[checkY][checkX] == CellState::SHIP) {
-                return false;
-            }
-        }
-    }
+ShootResult Game::hitShip(uint64_t x, uint64_t y, Ship& ship, Board& board, FleetStatus& fleet) {
+    board.set(x, y, CellState::HIT);
+    if (!ship.tryHit(x, y)) return ShootResult::HIT;
 
-    return true;
-}
+    --fleet.aliveCells;
+    if (!ship.isDestroyed()) return ShootResult::HIT;
 
-bool Game::tryHitShip(uint64_t x, uint64_t y, Ship& ship) {
-    return ship.tryHit(x, y);
+    --fleet.aliveShips;
+    // для отката пробного выстрела: какие клетки ореола были пустыми
+    if (speculating) killHalo = emptyHalo(ship, board);
+    board.fillRect(ship.getX(), ship.getY(), ship.getEndX(), ship.getEndY(), CellState::KILL);
+    markAroundShip(ship, board);
+    return ShootResult::KILL;
 }
 
 ShootResult Game::processShot(uint64_t x, uint64_t y) {
-    if (!isValidPosition(x, y)) {
+    // кораблей удалённого соперника у нас нет, исход сообщает applyShotResult
+    if (remoteOpponent || !isValidPosition(x, y)) {
         return ShootResult::INVALID;
     }
 
-    if (enemyBoard[y][x] == CellState::SHIP) {
-        enemyBoard[y][x] = CellState::HIT;
-        
-        for (auto& ship : enemyShips) {
-            if (ship.containsPosition(x, y)) {
-                bool isDestroyed = true;
-                for (int i = 0; i < ship.getSize(); ++i) {
-                    uint64_t checkX = ship.isHorizontal() ? ship.getX() + i : ship.getX();
-                    uint64_t checkY = ship.isHorizontal() ? ship.getY() : ship.getY() + i;
-                    if (enemyBoard[checkY][checkX] == CellState::SHIP) {
-                        isDestroyed = false;
-                        break;
-                    }
-                }
-                
-                if (isDestroyed) {
-                    for (int i = 0; i < ship.getSize(); ++i) {
-                        uint64_t shipX = ship.isHorizontal() ? ship.getX() + i : ship.getX();
-                        uint64_t shipY = ship.isHorizontal() ? ship.getY() : ship.getY() + i;
-                        enemyBoard[shipY][shipX] = CellState::KILL;
-                    }
-                    markAroundShip(ship, enemyBoard);
-                    return ShootResult::KILL;
-                }
-                return ShootResult::HIT;
-            }
-        }
-    } else if (enemyBoard[y][x] == CellState::EMPTY) {
-        enemyBoard[y][x] = CellState::MISS;
+    CellState state = enemyBoard.get(x, y);
+    if (state == CellState::SHIP) {
+        Ship& ship = enemyShips[enemyBoard.getShipId(x, y) - 1];
+        ShootResult result = hitShip(x, y, ship, enemyBoard, enemyFleet);
+        recordShot(true, x, y, result, result == ShootResult::KILL ? &ship : nullptr);
+        return result;
+    } else if (state == CellState::EMPTY) {
+        enemyBoard.set(x, y, CellState::MISS);
+        recordShot(true, x, y, ShootResult::MISS, nullptr);
         return ShootResult::MISS;
     }
     
     return ShootResult::INVALID;
 }
 
-void Game::markAroundShip(const Ship& ship, std::vector<std::vector<CellState>>& board) {
-    int startX = std::max(0, static_cast<int>(ship.getX()) - 1);
-    int startY = std::max(0, static_cast<int>(ship.getY()) - 1);
-    int shipEndX = static_cast<int>(ship.getX() + (ship.isHorizontal() ? ship.getSize() - 1 : 0));
-    int shipEndY = static_cast<int>(ship.getY() + (ship.isHorizontal() ? 0 : ship.getSize() - 1));
-    int endX = std::min(static_cast<int>(width - 1), shipEndX + 1);
-    int endY = std::min(static_cast<int>(height - 1), shipEndY + 1);
-
-    // вокруг мисс
-    for (int y = startY; y <= endY; ++y) {
-        for (int x = startX; x <= endX; ++x) {
-            bool isShipCell = false;
-            if (ship.isHorizontal()) {
-                isShipCell = (y == ship.getY() && x >= ship.getX() && x <= shipEndX);
-            } else {
-                isShipCell = (x == ship.getX() && y >= ship.getY() && y <= shipEndY);
-            }
-            
-            if (!isShipCell && board[y][x] == CellState::EMPTY) {
-                board[y][x] = CellState::MISS;
-            }
-        }
+void Game::recordShot(bool byPlayer, uint64_t x, uint64_t y, ShootResult result, const Ship* killed) {
+    if (speculating) {
+        // пробный выстрел виден только журналу отката
+        const Board& board = byPlayer ? enemyBoard : myBoard;
+        undoLog.push_back({x, y, killed ? killHalo : 0, board.getShipId(x, y), byPlayer, result});
+        ++version;
+        return;
+    }
+    METRIC_ADD(byPlayer ? Counter::PLAYER_SHOTS : Counter::ENEMY_SHOTS, 1);
+    ++version;
+    if (!trackChanges) {
+        oldestVersion = version;
+    } else if (killed) {
+        // корабль стал KILL, а ореол - MISS
+        uint64_t x0 = killed->getX(), y0 = killed->getY();
+        logRect(byPlayer ? enemyBoard : myBoard, byPlayer, x0 ? x0 - 1 : 0, y0 ? y0 - 1 : 0,
+                killed->getEndX() + 1, killed->getEndY() + 1);
+    } else {
+        logRect(byPlayer ? enemyBoard : myBoard, byPlayer, x, y, x, y);
+    }
+    if (byPlayer && remoteOpponent) {
+        journalEvent(JournalEvent::SHOT_RESULT, x, y, static_cast<uint8_t>(result));
+    } else {
+        journalEvent(byPlayer ? JournalEvent::PLAYER_SHOT : JournalEvent::ENEMY_SHOT, x, y);
     }
+    if (shotObserver) shotObserver({byPlayer, x, y, result, killed, version});
 }
 
-std::pair<uint64_t, uint64_t> Game::getNextOrderedShot() {
-    static uint64_t nextX = 0;
-    static uint64_t nextY = 0;
-
-    while (nextY < height) {
-        while (nextX < width) {
-            if (enemyBoard[nextY][nextX] == CellState::EMPTY) {
-                uint64_t x = nextX++;
-                return {x, nextY};
-            }
-            nextX++;
+void Game::logRect(const Board& board, bool enemy, uint64_t x0, uint64_t y0, uint64_t x1, uint64_t y1) {
+    x1 = std::min(x1, width - 1);
+    y1 = std::min(y1, height - 1);
+    if (changes.size() >= MAX_CHANGES) {
+        // старшая половина уходит, клиентам старше неё отдаётся снимок
+        oldestVersion = changes[MAX_CHANGES / 2 - 1].version;
+        changes.erase(changes.begin(), changes.begin() + MAX_CHANGES / 2);
+    }
+    for (uint64_t y = y0; y <= y1; ++y) {
+        for (uint64_t x = x0; x <= x1; ++x) {
+            changes.push_back({version, x, y, board.get(x, y), enemy});
         }
-        nextX = 0;
-        nextY++;
     }
-    return {0, 0};
 }
 
-std::pair<uint64_t, uint64_t> Game::getNextCustomShot() {
-    static std::vector<std::pair<uint64_t, uint64_t>> lastHits;
-    static std::vector<std::vector<bool>> visited(height, std::vector<bool>(width, false));
+void Game::markRebuilt() {
+    ++version;
+    oldestVersion = version;
+    changes.clear();
+}
+
+void Game::setChangeTracking(bool enabled) {
+    trackChanges = enabled;
+    oldestVersion = version;
+    changes.clear();
+    changes.shrink_to_fit();
+}
 
-    if (!lastHits.empty()) {
-        auto [lastX, lastY] = lastHits.back();
-        
-        const std::vector<std::pair<int, int>> directions = {{0, 1}, {1, 0}, {0, -1}, {-1, 0}};
-        for (const auto& [dx, dy] : directions) {
-            uint64_t newX = lastX + dx;
-            uint64_t newY = lastY + dy;
-            
-            if (isValidPosition(newX, newY) && !visited[newY][newX]) {
-                visited[newY][newX] = true;
-                return {newX, newY};
-            }
-        }
-        
-        lastHits.pop_back();
-        return getNextCustomShot();
-    }
-    
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    
-    while (true) {
-        uint64_t x = std::uniform_int_distribution<uint64_t>(0, width - 1)(gen);
-        uint64_t y = std::uniform_int_distribution<uint64_t>(0, height - 1)(gen);
-        
-        if ((x + y) % 2 == 0 && !visited[y][x]) {
-            visited[y][x] = true;
-            if (enemyBoard[y][x] == CellState::HIT) {
-                lastHits.push_back({x, y});
-            }
-            
-            return {x, y};
-        }
+bool Game::getChangesSince(uint64_t since, std::vector<CellChange>& out) const {
+    out.clear();
+    if (since < oldestVersion || since > version) return false;
+    auto first = std::upper_bound(changes.begin(), changes.end(), since,
+                                  [](uint64_t v, const CellChange& change) { return v < change.version; });
+    out.assign(first, changes.end());
+    return true;
+}
+
+void Game::markAroundShip(const Ship& ship, Board& board) {
+    // вокруг мисс, клетки самого корабля не пустые и не затрагиваются
+    board.fillEmptyInRect(ship.getX() ? ship.getX() - 1 : 0, ship.getY() ? ship.getY() - 1 : 0,
+                          ship.getEndX() + 1, ship.getEndY() + 1, CellState::MISS);
+}
+
+ShotStrategy& Game::activeStrategy() {
+    // вероятностным стратегиям нужны плотные счётчики на каждую клетку
+    if (myBoard.isSparse() && currentStrategy != Strategy::ORDERED) return customStrategy;
+    switch (currentStrategy) {
+        case Strategy::ORDERED: return orderedStrategy;
+        case Strategy::DENSITY: return densityStrategy;
+        case Strategy::MONTE_CARLO: return monteCarloStrategy;
+        default: return customStrategy;
     }
 }
 
 std::pair<uint64_t, uint64_t> Game::getNextShot() {
-    return (currentStrategy == Strategy::ORDERED) ? 
-           getNextOrderedShot() : getNextCustomShot();
+    METRIC_TIMER(timer, static_cast<Histogram>(static_cast<size_t>(Histogram::DECISION_ORDERED) +
+                                               static_cast<size_t>(currentStrategy)));
+    ShotDeadline deadline = timeLimit ? std::chrono::steady_clock::now() + std::chrono::milliseconds(timeLimit)
+                                      : ShotDeadline::max();
+    return activeStrategy().nextShot(targetBoard(), deadline);
 }
 
-bool Game::startGame() {
-    std::cout << "Starting game..." << std::endl;
-    std::cout << "Field size: " << width << "x" << height << std::endl;
-    std::cout << "Ship counts: ";
-    for (size_t i = 0; i < shipCounts.size(); ++i) {
-        std::cout << (i+1) << "-deck: " << shipCounts[i] << ", ";
+void Game::resetStrategy() {
+    resetStrategy(rng());
+}
+
+void Game::resetStrategy(uint64_t seed) {
+    strategySeed = seed;
+    // известны только количества кораблей и уже потопленные
+    int alive[4];
+    for (int size = 1; size <= 4; ++size) {
+        alive[size - 1] = shipCounts[size - 1];
+    }
+    for (const auto& ship : targetShips()) {
+        if (ship.isDestroyed()) --alive[ship.getSize() - 1];
     }
-    std::cout << std::endl;
+    activeStrategy().reset(targetBoard(), alive, seed);
+}
 
-    if (!isValidGameSetup()) {
-        std::cout << "Invalid game setup" << std::endl;
+bool Game::startGame() {
+    if (speculating) return false;
+    setupError.clear();
+    if (!isValidGameSetup(setupError)) {
         return false;
     }
     
-    // попытки на корабли
-    int maxAttempts = 100;
-    bool success = false;
-    
-    std::cout << "Attempting to place ships..." << std::endl;
-    while (maxAttempts > 0 && !success) {
-        generateRandomShipPlacement();
-        if (!myShips.empty() && !enemyShips.empty()) {
-            success = true;
-            std::cout << "Ships placed successfully" << std::endl;
-            break;
-        }
-        --maxAttempts;
-        if (maxAttempts % 10 == 0) {
-            std::cout << maxAttempts << " attempts remaining..." << std::endl;
-        }
+    PlacementResult placement = generateRandomShipPlacement();
+    if (placement == PlacementResult::INFEASIBLE) {
+        setupError = "Ships cannot be placed on a " + std::to_string(width) + "x" + std::to_string(height) + " field";
+        return false;
     }
-    
-    if (!success) {
-        std::cout << "Failed to place ships after " << (100 - maxAttempts) << " attempts" << std::endl;
+    if (placement != PlacementResult::OK) {
+        setupError = "Failed to place ships";
         return false;
     }
     
     gameStarted = true;
+    resetStrategy();
     myTurn = (mode == GameMode::SLAVE);
-
-    std::cout << "\nGame started! Available commands:\n";
-    std::cout << "- shot x y     : Make a shot at coordinates (x,y)\n";
-    std::cout << "- save file    : Save the game to a file\n";
-    std::cout << "- load file    : Load the game from a file\n";
-    std::cout << "- display      : Show the game boards\n";
-    std::cout << "- reveal       : Show enemy ships (debug)\n";
-    std::cout << "- stop         : Stop the game\n\n";
-    std::cout << "- exit        : Exit the program\n\n";
-
+    // расстановка случайная и в журнал не ложится - начало партии только снимком
+    if (journal) checkpoint();
     return true;
 }
 
-bool Game::isValidGameSetup() const {
+bool Game::isValidGameSetup(std::string& error) const {
     // проверка для поля
     if (width == 0 || height == 0) {
-        std::cout << "Invalid field size: " << width << "x" << height << std::endl;
+        error = "Invalid field size: " + std::to_string(width) + "x" + std::to_string(height);
         return false;
     }
 
@@ -424,31 +358,33 @@ bool Game::isValidGameSetup() const {
         }
     }
     if (!hasShips) {
-        std::cout << "No ships defined" << std::endl;
+        error = "No ships defined";
         return false;
     }
 
     // проверка на биг корабль
-    int maxShipSize = 0;
+    uint64_t maxShipSize = 0;
     for (size_t i = 0; i < shipCounts.size(); ++i) {
         if (shipCounts[i] > 0) {
             maxShipSize = i + 1;
         }
     }
     if (maxShipSize > width || maxShipSize > height) {
-        std::cout << "Largest ship size " << maxShipSize << " doesn't fit on " << width << "x" << height << " field" << std::endl;
+        error = "Largest ship size " + std::to_string(maxShipSize) + " doesn't fit on " +
+                std::to_string(width) + "x" + std::to_string(height) + " field";
         return false;
     }
 
-    // S кор
-    int totalShipCells = 0;
+    // S кор, размеры до uint64_t - считаем в 128 битах
+    unsigned __int128 totalShipCells = 0;
     for (size_t i = 0; i < shipCounts.size(); ++i) {
-        totalShipCells += (i + 1) * shipCounts[i];
+        totalShipCells += static_cast<unsigned __int128>(i + 1) * shipCounts[i];
     }
 
     // Sк < Sп
-    if (totalShipCells > (width * height) / 2) {
-        std::cout << "Total ship cells " << totalShipCells << " is too large for field area " << width * height << std::endl;
+    unsigned __int128 area = static_cast<unsigned __int128>(width) * height;
+    if (totalShipCells > area / 2) {
+        error = "Total ship cells are too large for field area " + std::to_string(width) + "x" + std::to_string(height);
         return false;
     }
 
@@ -469,94 +405,108 @@ uint64_t Game::getShipCount(int shipSize) const {
 }
 
 bool Game::setWidth(uint64_t w) {
-    if (gameStarted || w > 100) return false;
+    if (gameStarted || speculating) return false;
     width = w;
     initializeBoards();
+    journalEvent(JournalEvent::SET_WIDTH, w);
     return true;
 }
 
 bool Game::setHeight(uint64_t h) {
-    if (gameStarted || h > 100) return false;
+    if (gameStarted || speculating) return false;
     height = h;
     initializeBoards();
+    journalEvent(JournalEvent::SET_HEIGHT, h);
     return true;
 }
 
 void Game::initializeBoards() {
-    myBoard.clear();
-    enemyBoard.clear();
-    
-    if (width == 0 || height == 0) return;
-    
-    // доски
-    myBoard = std::vector<std::vector<CellState>>(height, std::vector<CellState>(width, CellState::EMPTY));
-    enemyBoard = std::vector<std::vector<CellState>>(height, std::vector<CellState>(width, CellState::EMPTY));
+    // доски, флоты без досок смысла не имеют
+    markRebuilt();
+    myBoard.reset(width, height);
+    enemyBoard.reset(width, height);
+    myShips.clear();
+    enemyShips.clear();
+    myFleet = FleetStatus();
+    enemyFleet = FleetStatus();
 }
 
 void Game::displayBoards() const {
-    std::cout << "\nGame Mode: " << (mode == GameMode::MASTER ? "Master" : "Slave") << std::endl;
+    std::cout << "\nGame Mode: " << (mode == GameMode::MASTER ? "Master" : "Slave") << '\n';
     if (gameStarted) {
-        std::cout << "Current Turn: " << (myTurn ? "Your Turn" : "Enemy's Turn") << std::endl;
+        std::cout << "Current Turn: " << (myTurn ? "Your Turn" : "Enemy's Turn") << '\n';
+    }
+    std::cout << '\n';
+
+    if (width > MAX_DISPLAY_SIZE || height > MAX_DISPLAY_SIZE) {
+        std::cout << "Field " << width << "x" << height << " is too large to display" << '\n';
+        std::cout << "My ships alive: " << myFleet.aliveShips << "/" << myFleet.totalShips
+                  << ", enemy ships alive: " << enemyFleet.aliveShips << "/" << enemyFleet.totalShips << '\n';
+        return;
     }
-    std::cout << std::endl;
 
     auto printColumnNumbers = [this]() {
         std::cout << "     ";
         for (uint64_t x = 0; x < width; ++x) {
             std::cout << x << "   ";
         }
-        std::cout << std::endl;
+        std::cout << '\n';
     };
 
-    std::cout << "\nMy Board:" << std::endl;
+    std::cout << "\nMy Board:" << '\n';
     printColumnNumbers();
 
     for (uint64_t y = 0; y < height; ++y) {
         std::cout << y << "   ";
         for (uint64_t x = 0; x < width; ++x) {
             char symbol = ' ';
-            switch (myBoard[y][x]) {
+            switch (myBoard.get(x, y)) {
                 case CellState::EMPTY: symbol = '.'; break;
-                case CellState::SHIP: {
-                    for (const auto& ship : myShips) {
-                        if (ship.containsPosition(x, y)) {
-                            symbol = '0' + ship.getSize();
-                            break;
-                        }
-                    }
+                case CellState::SHIP:
+                    symbol = '0' + myShips[myBoard.getShipId(x, y) - 1].getSize();
                     break;
-                }
                 case CellState::HIT: symbol = 'X'; break;
+                case CellState::KILL: symbol = 'X'; break;
                 case CellState::MISS: symbol = 'O'; break;
             }
             std::cout << symbol << "   ";
         }
-        std::cout << std::endl;
+        std::cout << '\n';
     }
-    std::cout << std::endl;
+    std::cout << '\n';
 
-    std::cout << "Enemy Board:" << std::endl;
+    std::cout << "Enemy Board:" << '\n';
     printColumnNumbers();
 
     for (uint64_t y = 0; y < height; ++y) {
         std::cout << y << "   ";
         for (uint64_t x = 0; x < width; ++x) {
             char symbol = ' ';
-            switch (enemyBoard[y][x]) {
+            switch (enemyBoard.get(x, y)) {
                 case CellState::EMPTY: symbol = '.'; break;
                 case CellState::SHIP: symbol = '.'; break;
                 case CellState::HIT: symbol = 'X'; break;
+                case CellState::KILL: symbol = 'X'; break;
                 case CellState::MISS: symbol = 'O'; break;
             }
             std::cout << symbol << "   ";
         }
-        std::cout << std::endl;
+        std::cout << '\n';
     }
-    std::cout << std::endl;
+    std::cout << '\n';
 }
 
 void Game::displayEnemyShips() const {
     std::cout << "\nEnemy ships positions:\n";
+
+    if (width > MAX_DISPLAY_SIZE || height > MAX_DISPLAY_SIZE) {
+        for (const auto& ship : enemyShips) {
+            std::cout << ship.getSize() << "-deck at (" << ship.getX() << ", " << ship.getY() << ") "
+                      << (ship.isHorizontal() ? "horizontal" : "vertical") << "\n";
+        }
+        std::cout << "\n";
+        return;
+    }
     
     std::vector<std::vector<char>> tempBoard(height, std::vector<char>(width, '.'));
 
@@ -592,7 +542,9 @@ void Game::displayEnemyShips() const {
 }
 
 bool Game::stopGame() {
+    if (speculating) return false;
     gameStarted = false;
+    journalEvent(JournalEvent::STOP_GAME);
     return true;
 }
 
@@ -605,39 +557,27 @@ bool Game::saveToFile(const std::string& path) const {
     if (!file) return false;
 
     file << width << " " << height << "\n";
-    file << currentStrategy << "\n";
-    file << gameStarted << "\n";
-    file << myTurn << "\n";
-
-    file << myShips.size() << "\n";
     for (const auto& ship : myShips) {
-        file << ship.getSize() << " " << ship.getX() << " " << ship.getY() << " "
+        file << static_cast<int>(ship.getSize()) << " " << ship.getX() << " " << ship.getY() << " "
              << (ship.isHorizontal() ? "1" : "0") << "\n";
     }
-
-    for (uint64_t i = 0; i < height; ++i) {
-        for (uint64_t j = 0; j < width; ++j) {
-            file << static_cast<int>(myBoard[i][j]) << " ";
-        }
-        file << "\n";
-    }
-
-    for (uint64_t i = 0; i < height; ++i) {
-        for (uint64_t j = 0; j < width; ++j) {
-            file << static_cast<int>(enemyBoard[i][j]) << " ";
-        }
-        file << "\n";
-    }
-
-    return true;
+    return static_cast<bool>(file);
 }
 
 bool Game::loadFromFile(const std::string& path) {
-    if (gameStarted) return false;
-
-    std::ifstream file(path);
+    if (speculating) return false;
+    std::ifstream file(path, std::ios::binary);
     if (!file) return false;
 
+    // бинарный снимок узнаётся по сигнатуре и восстанавливает партию целиком
+    uint64_t magic = 0;
+    if (file.read(reinterpret_cast<char*>(&magic), sizeof(magic)) && magic == snapshot::MAGIC) {
+        return loadSnapshot(path);
+    }
+    if (gameStarted) return false;
+    file.clear();
+    file.seekg(0);
+
     uint64_t w, h;
     file >> w >> h;
     
@@ -661,81 +601,32 @@ bool Game::loadFromFile(const std::string& path) {
 }
 
 bool Game::isFinished() const {
-    // проверка на кол-во кораблей противника (победа)
-    for (const auto& ship : enemyShips) {
-        bool allHit = true;
-        for (int i = 0; i < ship.getSize(); i++) {
-            uint64_t x = ship.isHorizontal() ? ship.getX() + i : ship.getX();
-            uint64_t y = ship.isHorizontal() ? ship.getY() : ship.getY() + i;
-            if (enemyBoard[y][x] != CellState::HIT) {
-                allHit = false;
-                break;
-            }
-        }
-        if (!allHit) return false;
-    }
-    return true;
+    return isWinner() || isLoser();
 }
 
 bool Game::isWinner() const {
-    if (!isFinished()) return false;
-    
-    // вторая проверка
-    for (const auto& ship : enemyShips) {
-        bool allHit = true;
-        for (int i = 0; i < ship.getSize(); i++) {
-            uint64_t x = ship.isHorizontal() ? ship.getX() + i : ship.getX();
-            uint64_t y = ship.isHorizontal() ? ship.getY() : ship.getY() + i;
-            if (enemyBoard[y][x] != CellState::HIT) {
-                allHit = false;
-                break;
-            }
-        }
-        if (!allHit) return false;
-    }
-    return true;
+    // все корабли противника потоплены
+    return enemyFleet.totalShips > 0 && enemyFleet.aliveShips == 0;
 }
 
 bool Game::isLoser() const {
-    if (!isFinished()) return false;
-    
-    // проверка на наши корабли (поражение)
-    for (const auto& ship : myShips) {
-        bool allHit = true;
-        for (int i = 0; i < ship.getSize(); i++) {
-            uint64_t x = ship.isHorizontal() ? ship.getX() + i : ship.getX();
-            uint64_t y = ship.isHorizontal() ? ship.getY() : ship.getY() + i;
-            if (myBoard[y][x] != CellState::HIT) {
-                allHit = false;
-                break;
-            }
-        }
-        if (!allHit) return false;
-    }
-    return true;
+    // все наши корабли потоплены, победа имеет приоритет
+    return myFleet.totalShips > 0 && myFleet.aliveShips == 0 && !isWinner();
 }
 
 bool Game::canPlaceEnemyShip(uint64_t x, uint64_t y, int size, bool horizontal) {
+    if (x >= width || y >= height) return false;
     if (horizontal) {
-        if (x + size > width) return false;
+        if (static_cast<uint64_t>(size) > width - x) return false;
     } else {
-        if (y + size > height) return false;
+        if (static_cast<uint64_t>(size) > height - y) return false;
     }
 
-    for (int i = -1; i <= size; i++) {
-        for (int j = -1; j <= 1; j++) {
-            uint64_t checkX = horizontal ? x + i : x + j;
-            uint64_t checkY = horizontal ? y + j : y + i;
-
-            if (checkX >= width || checkY >= height) continue;
-            if (checkX == (uint64_t)-1 || checkY == (uint64_t)-1) continue;
-
-            if (enemyBoard[checkY][checkX] == CellState::SHIP) {
-                return false;
-            }
-        }
-    }
-    return true;
+    // корабль вместе с ореолом в одну клетку
+    uint64_t endX = horizontal ? x + size - 1 : x;
+    uint64_t endY = horizontal ? y : y + size - 1;
+    return !enemyBoard.anyInRect(x ? x - 1 : 0, y ? y - 1 : 0,
+                                 endX + 1, endY + 1, CellState::SHIP);
 }
 
 bool Game::placeEnemyShip(uint64_t x, uint64_t y, int size, bool horizontal) {
@@ -743,16 +634,7 @@ bool Game::placeEnemyShip(uint64_t x, uint64_t y, int size, bool horizontal) {
         return false;
     }
 
-    Ship newShip(x, y, size, horizontal);
-    enemyShips.push_back(newShip);
-
-    for (int i = 0; i < size; ++i) {
-        if (horizontal) {
-            enemyBoard[y][x + i] = CellState::SHIP;
-        } else {
-            enemyBoard[y + i][x] = CellState::SHIP;
-        }
-    }
+    addShip(Ship(x, y, size, horizontal), enemyShips, enemyBoard, enemyFleet);
     return true;
 }
 
@@ -762,48 +644,95 @@ ShootResult Game::processEnemyShot(uint64_t x, uint64_t y) {
     }
 
     // молния
-    if (myBoard[y][x] == CellState::HIT || 
-        myBoard[y][x] == CellState::KILL ||
-        myBoard[y][x] == CellState::MISS) {
+    CellState state = myBoard.get(x, y);
+    if (state == CellState::HIT || 
+        state == CellState::KILL ||
+        state == CellState::MISS) {
         return ShootResult::INVALID;
     }
 
-    bool isHit = false;
-    bool isDestroyed = false;
-
     // хит мисс
-    for (auto& ship : myShips) {
-        if (ship.containsPosition(x, y)) {
-            isHit = true;
-            myBoard[y][x] = CellState::HIT;
-            
-            if (ship.tryHit(x, y)) {
-                if (ship.isDestroyed()) {
-                    isDestroyed = true;
-                    markAroundShip(ship, myBoard);
-                }
-            }
-            break;
-        }
+    uint16_t id = myBoard.getShipId(x, y);
+    ShootResult result = ShootResult::MISS;
+    if (id == 0) {
+        myBoard.set(x, y, CellState::MISS);
+    } else {
+        result = hitShip(x, y, myShips[id - 1], myBoard, myFleet);
     }
 
-    if (!isHit) {
-        myBoard[y][x] = CellState::MISS;
-        return ShootResult::MISS;
+    const Ship* killed = result == ShootResult::KILL ? &myShips[id - 1] : nullptr;
+    // стратегия удалённой игры стреляет по чужому полю, выстрелы по нам ей не нужны
+    if (!speculating && !remoteOpponent) activeStrategy().onShot(x, y, result, killed);
+    recordShot(false, x, y, result, killed);
+    return result;
+}
+
+bool Game::applyShotResult(uint64_t x, uint64_t y, ShootResult result) {
+    if (!remoteOpponent || !gameStarted || speculating || !isValidPosition(x, y)) return false;
+    if (enemyBoard.get(x, y) != CellState::EMPTY) return false;
+    if (result == ShootResult::MISS) {
+        enemyBoard.set(x, y, CellState::MISS);
+        activeStrategy().onShot(x, y, result, nullptr);
+        recordShot(true, x, y, result, nullptr);
+        return true;
+    }
+    if ((result != ShootResult::HIT && result != ShootResult::KILL) || enemyFleet.aliveCells == 0) return false;
+
+    const Ship* killed = nullptr;
+    if (result == ShootResult::KILL) {
+        // корабли не касаются друг друга, поэтому соседние HIT - палубы этого же корабля
+        uint64_t left = x, right = x, top = y, bottom = y;
+        while (left > 0 && x - left < 4 && enemyBoard.get(left - 1, y) == CellState::HIT) --left;
+        while (right + 1 < width && right - x < 4 && enemyBoard.get(right + 1, y) == CellState::HIT) ++right;
+        while (top > 0 && y - top < 4 && enemyBoard.get(x, top - 1) == CellState::HIT) --top;
+        while (bottom + 1 < height && bottom - y < 4 && enemyBoard.get(x, bottom + 1) == CellState::HIT) ++bottom;
+        bool horizontal = right > left;
+        uint64_t size = horizontal ? right - left + 1 : bottom - top + 1;
+        if ((horizontal && bottom > top) || size > 4) return false;
+        uint64_t sunk = 0;
+        for (const auto& ship : enemyShips) {
+            if (ship.getSize() == size) ++sunk;
+        }
+        if (sunk >= shipCounts[size - 1]) return false;
+
+        enemyShips.emplace_back(horizontal ? left : x, horizontal ? y : top, static_cast<uint8_t>(size), horizontal,
+                                static_cast<uint8_t>((1 << size) - 1));
+        const Ship& ship = enemyShips.back();
+        uint16_t id = static_cast<uint16_t>(enemyShips.size());
+        for (uint64_t i = 0; i < size; ++i) {
+            enemyBoard.setShipId(horizontal ? left + i : x, horizontal ? y : top + i, id);
+        }
+        enemyBoard.fillRect(ship.getX(), ship.getY(), ship.getEndX(), ship.getEndY(), CellState::KILL);
+        markAroundShip(ship, enemyBoard);
+        --enemyFleet.aliveShips;
+        killed = &ship;
+    } else {
+        enemyBoard.set(x, y, CellState::HIT);
     }
+    --enemyFleet.aliveCells;
+    activeStrategy().onShot(x, y, result, killed);
+    recordShot(true, x, y, result, killed);
+    return true;
+}
 
-    return isDestroyed ? ShootResult::KILL : ShootResult::HIT;
+FleetStatus Game::remoteFleet() const {
+    FleetStatus fleet;
+    for (size_t i = 0; i < shipCounts.size(); ++i) {
+        fleet.totalShips += shipCounts[i];
+        fleet.aliveCells += (i + 1) * shipCounts[i];
+    }
+    uint64_t hitCells = enemyBoard.count(CellState::HIT) + enemyBoard.count(CellState::KILL);
+    fleet.aliveShips = fleet.totalShips - std::min<uint64_t>(enemyShips.size(), fleet.totalShips);
+    fleet.aliveCells -= std::min(hitCells, fleet.aliveCells);
+    return fleet;
 }
 
 bool Game::isValidPlacement(const Ship& ship) const {
-    if (ship.getX() < 0 || ship.getY() < 0) return false;
-    
+    if (ship.getX() >= width || ship.getY() >= height) return false;
     if (ship.isHorizontal()) {
-        if (ship.getX() + ship.getSize() > width) return false;
-        if (ship.getY() >= height) return false;
+        if (ship.getSize() > width - ship.getX()) return false;
     } else {
-        if (ship.getY() + ship.getSize() > height) return false;
-        if (ship.getX() >= width) return false;
+        if (ship.getSize() > height - ship.getY()) return false;
     }
 
     // проверка пересеч
@@ -0,0 +1,135 @@
+#include "../include/Game.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Снимок заменяет старый только целиком и уже лёжа на диске: запись во временный
+// файл, fsync, rename поверх старого и fsync каталога.
+bool replaceFile(const std::string& path, const std::string& data) {
+    std::string temp = path + ".tmp";
+#ifdef _WIN32
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if (!file.write(data.data(), static_cast<std::streamsize>(data.size())) || !file.flush()) return false;
+    }
+    std::error_code error;
+    std::filesystem::rename(temp, path, error);
+    return !error;
+#else
+    int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t chunk = ::write(fd, data.data() + written, data.size() - written);
+        if (chunk <= 0) break;
+        written += static_cast<size_t>(chunk);
+    }
+    bool ok = written == data.size() && ::fsync(fd) == 0;
+    ::close(fd);
+    if (!ok || std::rename(temp.c_str(), path.c_str()) != 0) return false;
+
+    std::string dir = std::filesystem::path(path).parent_path().string();
+    int dirFd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_CLOEXEC);
+    if (dirFd >= 0) {
+        ::fsync(dirFd);
+        ::close(dirFd);
+    }
+    return true;
+#endif
+}
+
+} // namespace
+
+void Game::journalEvent(JournalEvent event, uint64_t x, uint64_t y, uint8_t size, uint8_t horizontal) {
+    if (!journal || speculating) return;
+    journal->append(event, x, y, size, horizontal);
+    // неудачная запись тоже занимает номер: восстановление остановится перед ней
+    journalSequence = journal->lastSequence();
+}
+
+bool Game::checkpoint() {
+    // снимок покрывает всё выданное журналом, в том числе незаписанное
+    journalSequence = journal->lastSequence();
+    std::string buffer;
+    writeSnapshot(buffer);
+    if (!replaceFile(journalPath + ".snap", buffer)) return false;
+    // старые записи уже в снимке; упади мы до обрезки, их отсеют по номеру
+    return journal->clear();
+}
+
+bool Game::replay(const JournalRecord& record) {
+    switch (record.event) {
+        case JournalEvent::PLAYER_SHOT:
+            return processShot(record.x, record.y) != ShootResult::INVALID;
+        case JournalEvent::ENEMY_SHOT:
+            return processEnemyShot(record.x, record.y) != ShootResult::INVALID;
+        case JournalEvent::PLACE_SHIP:
+            return placeShip(record.x, record.y, record.size, record.horizontal != 0);
+        case JournalEvent::SET_STRATEGY: {
+            // у этого события x - не координата, а зерно стратегии, size - Strategy
+            uint64_t seed = record.x;
+            if (record.size > static_cast<uint8_t>(Strategy::MONTE_CARLO)) return false;
+            currentStrategy = static_cast<Strategy>(record.size);
+            // то же зерно, что и до падения
+            resetStrategy(seed);
+            return true;
+        }
+        case JournalEvent::SWITCH_TURN:
+            myTurn = !myTurn;
+            return true;
+        case JournalEvent::STOP_GAME:
+            gameStarted = false;
+            return true;
+        case JournalEvent::SET_WIDTH:
+            return setWidth(record.x);
+        case JournalEvent::SET_HEIGHT:
+            return setHeight(record.x);
+        case JournalEvent::SET_SHIP_COUNT:
+            return setShipCount(record.size, record.x);
+        case JournalEvent::SET_TIME_LIMIT:
+            return setTimeLimit(record.x);
+        case JournalEvent::SET_MONTE_CARLO:
+            return setMonteCarloOptions(record.x, record.y);
+        case JournalEvent::SHOT_RESULT:
+            if (record.size > static_cast<uint8_t>(ShootResult::KILL)) return false;
+            return applyShotResult(record.x, record.y, static_cast<ShootResult>(record.size));
+    }
+    return false;
+}
+
+bool Game::openJournal(const std::string& path) {
+    closeJournal();
+    std::string snapshotPath = path + ".snap";
+    std::error_code error;
+    if (std::filesystem::exists(snapshotPath, error)) {
+        if (!loadSnapshot(snapshotPath)) return false;
+        std::vector<JournalRecord> records;
+        Journal::read(path + ".journal", records);
+        for (const auto& record : records) {
+            if (record.sequence <= journalSequence) continue;
+            // после пропуска или несыгравшего события продолжать нельзя
+            if (record.sequence != journalSequence + 1 || !replay(record)) break;
+            journalSequence = record.sequence;
+        }
+    }
+
+    auto opened = std::make_unique<Journal>();
+    if (!opened->open(path + ".journal", journalSequence)) return false;
+    journal = std::move(opened);
+    journalPath = path;
+    if (checkpoint()) return true;
+    closeJournal();
+    return false;
+}
+
+void Game::closeJournal() {
+    journal.reset();
+    journalPath.clear();
+}
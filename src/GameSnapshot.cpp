@@ -0,0 +1,281 @@
+#include "../include/Game.hpp"
+#include "../include/GameSnapshot.hpp"
+#include <cstring>
+#include <fstream>
+#include <vector>
+#ifdef _WIN32
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+uint64_t snapshot::checksum(const unsigned char* data, size_t size) {
+    const uint64_t PRIME = 0x9E3779B97F4A7C15ULL;
+    auto mix = [PRIME](uint64_t hash, uint64_t word) {
+        hash = (hash ^ word) * PRIME;
+        return (hash << 29) | (hash >> 35);
+    };
+    // цепочки не зависят друг от друга, умножения идут параллельно
+    uint64_t lanes[4] = {PRIME, PRIME + 1, PRIME + 2, PRIME + 3};
+    size_t words = size / sizeof(uint64_t);
+    size_t i = 0;
+    for (; i + 4 <= words; i += 4) {
+        uint64_t block[4];
+        std::memcpy(block, data + i * sizeof(uint64_t), sizeof(block));
+        for (int lane = 0; lane < 4; ++lane) lanes[lane] = mix(lanes[lane], block[lane]);
+    }
+    for (; i < words; ++i) {
+        uint64_t word;
+        std::memcpy(&word, data + i * sizeof(uint64_t), sizeof(word));
+        lanes[0] = mix(lanes[0], word);
+    }
+    uint64_t hash = mix(mix(mix(mix(size, lanes[0]), lanes[1]), lanes[2]), lanes[3]);
+    return hash ^ (hash >> 32);
+}
+
+namespace {
+
+// Файл целиком в памяти только для чтения: отображение, где оно есть, иначе чтение.
+class MappedFile {
+private:
+    const unsigned char* bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    std::vector<unsigned char> buffer;
+#else
+    void* mapping = MAP_FAILED;
+#endif
+
+public:
+    explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return;
+        buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        bytes = buffer.data();
+        length = buffer.size();
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat info;
+        if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+            mapping = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED) {
+                bytes = static_cast<const unsigned char*>(mapping);
+                length = static_cast<size_t>(info.st_size);
+            }
+        }
+        // отображение живёт и без дескриптора
+        ::close(fd);
+#endif
+    }
+
+    ~MappedFile() {
+#ifndef _WIN32
+        if (mapping != MAP_FAILED) ::munmap(mapping, length);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const unsigned char* data() const { return bytes; }
+    size_t size() const { return length; }
+};
+
+bool validShip(const snapshot::ShipRecord& record, uint64_t width, uint64_t height) {
+    if (record.size < 1 || record.size > 4 || record.horizontal > 1) return false;
+    if (record.x >= width || record.y >= height) return false;
+    return record.horizontal ? record.size <= width - record.x : record.size <= height - record.y;
+}
+
+bool validShips(const unsigned char* records, uint64_t count, uint64_t width, uint64_t height) {
+    for (uint64_t i = 0; i < count; ++i) {
+        snapshot::ShipRecord record;
+        std::memcpy(&record, records + i * sizeof(record), sizeof(record));
+        if (!validShip(record, width, height)) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+void Game::writeSnapshot(std::string& out) const {
+    snapshot::Header header = {};
+    header.magic = snapshot::MAGIC;
+    header.version = snapshot::VERSION;
+    header.headerSize = sizeof(header);
+    header.width = width;
+    header.height = height;
+    for (int i = 0; i < 4; ++i) {
+        header.shipCounts[i] = shipCounts[i];
+        header.remainingShips[i] = remainingShips[i];
+    }
+    header.timeLimit = timeLimit;
+    header.monteCarloThreads = monteCarloStrategy.getThreads();
+    header.monteCarloSamples = monteCarloStrategy.getSamples();
+    header.strategySeed = strategySeed;
+    header.journalSequence = journalSequence;
+    header.myShips = myShips.size();
+    header.enemyShips = enemyShips.size();
+    header.myBoardWords = myBoard.packedWords();
+    header.enemyBoardWords = enemyBoard.packedWords();
+    header.mode = static_cast<uint8_t>(mode);
+    header.strategy = static_cast<uint8_t>(currentStrategy);
+    header.flags = (myTurn ? snapshot::MY_TURN : 0) | (gameStarted ? snapshot::STARTED : 0) |
+                   (placementPhase ? snapshot::PLACEMENT : 0) | (remoteOpponent ? snapshot::REMOTE : 0);
+
+    size_t shipBytes = (myShips.size() + enemyShips.size()) * sizeof(snapshot::ShipRecord);
+    size_t boardBytes = (header.myBoardWords + header.enemyBoardWords) * sizeof(uint64_t);
+    header.payloadWords = (shipBytes + boardBytes) / sizeof(uint64_t);
+    // resize не выделяет память, если буфер уже был такого размера
+    out.resize(sizeof(header) + shipBytes + boardBytes);
+
+    unsigned char* cursor = reinterpret_cast<unsigned char*>(&out[0]) + sizeof(header);
+    for (const auto* fleet : {&myShips, &enemyShips}) {
+        for (const auto& ship : *fleet) {
+            snapshot::ShipRecord record = {};
+            record.x = ship.getX();
+            record.y = ship.getY();
+            record.size = ship.getSize();
+            record.horizontal = ship.isHorizontal();
+            record.hitMask = ship.getHitMask();
+            std::memcpy(cursor, &record, sizeof(record));
+            cursor += sizeof(record);
+        }
+    }
+    myBoard.pack(cursor);
+    enemyBoard.pack(cursor + header.myBoardWords * sizeof(uint64_t));
+
+    std::memcpy(&out[0], &header, sizeof(header));
+    header.checksum = snapshot::checksum(reinterpret_cast<const unsigned char*>(out.data()) + snapshot::CHECKED_FROM,
+                                         out.size() - snapshot::CHECKED_FROM);
+    std::memcpy(&out[offsetof(snapshot::Header, checksum)], &header.checksum, sizeof(header.checksum));
+}
+
+bool Game::readSnapshot(const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    snapshot::Header header;
+    if (!bytes || size < sizeof(header) || speculating) return false;
+    std::memcpy(&header, bytes, sizeof(header));
+    if (header.magic != snapshot::MAGIC || header.version != snapshot::VERSION ||
+        header.headerSize != sizeof(header)) {
+        return false;
+    }
+    size_t payloadBytes = size - sizeof(header);
+    if (payloadBytes % sizeof(uint64_t) || header.payloadWords != payloadBytes / sizeof(uint64_t)) return false;
+    if (snapshot::checksum(bytes + snapshot::CHECKED_FROM, size - snapshot::CHECKED_FROM) != header.checksum) {
+        return false;
+    }
+
+    // сумма сошлась; дальше - защита от файла, собранного не writeSnapshot
+    if (header.mode > static_cast<uint8_t>(GameMode::SLAVE) ||
+        header.strategy > static_cast<uint8_t>(Strategy::MONTE_CARLO)) {
+        return false;
+    }
+    for (int i = 0; i < 4; ++i) {
+        if (header.shipCounts[i] > UINT8_MAX || header.remainingShips[i] < 0 ||
+            header.remainingShips[i] > INT32_MAX) {
+            return false;
+        }
+    }
+    if (header.timeLimit > MAX_TIME_LIMIT || header.monteCarloThreads == 0 || header.monteCarloSamples == 0) {
+        return false;
+    }
+    // номер корабля в клетке - uint16_t
+    if (header.myShips > UINT16_MAX || header.enemyShips > UINT16_MAX) return false;
+    const uint64_t SHIP_WORDS = sizeof(snapshot::ShipRecord) / sizeof(uint64_t);
+    uint64_t shipWords = (header.myShips + header.enemyShips) * SHIP_WORDS;
+    if (header.myBoardWords > header.payloadWords || header.enemyBoardWords > header.payloadWords ||
+        shipWords + header.myBoardWords + header.enemyBoardWords != header.payloadWords) {
+        return false;
+    }
+
+    const unsigned char* myRecords = bytes + sizeof(header);
+    const unsigned char* enemyRecords = myRecords + header.myShips * sizeof(snapshot::ShipRecord);
+    const unsigned char* myWords = enemyRecords + header.enemyShips * sizeof(snapshot::ShipRecord);
+    const unsigned char* enemyWords = myWords + header.myBoardWords * sizeof(uint64_t);
+    if (!validShips(myRecords, header.myShips, header.width, header.height) ||
+        !validShips(enemyRecords, header.enemyShips, header.width, header.height) ||
+        !Board::checkPacked(header.width, header.height, myWords, header.myBoardWords) ||
+        !Board::checkPacked(header.width, header.height, enemyWords, header.enemyBoardWords)) {
+        return false;
+    }
+
+    mode = static_cast<GameMode>(header.mode);
+    currentStrategy = static_cast<Strategy>(header.strategy);
+    width = header.width;
+    height = header.height;
+    for (int i = 0; i < 4; ++i) {
+        shipCounts[i] = static_cast<uint8_t>(header.shipCounts[i]);
+        remainingShips[i] = static_cast<int>(header.remainingShips[i]);
+    }
+    timeLimit = header.timeLimit;
+    monteCarloStrategy.configure(header.monteCarloThreads, header.monteCarloSamples);
+    myTurn = header.flags & snapshot::MY_TURN;
+    gameStarted = header.flags & snapshot::STARTED;
+    placementPhase = header.flags & snapshot::PLACEMENT;
+    remoteOpponent = header.flags & snapshot::REMOTE;
+
+    // версия продолжает расти: клиенты /changes увидят перестройку, а не старую историю
+    initializeBoards();
+    myBoard.unpack(myWords, header.myBoardWords);
+    enemyBoard.unpack(enemyWords, header.enemyBoardWords);
+    if (!restoreShips(myRecords, header.myShips, myShips, myBoard, myFleet) ||
+        !restoreShips(enemyRecords, header.enemyShips, enemyShips, enemyBoard, enemyFleet, remoteOpponent)) {
+        initializeBoards();
+        gameStarted = false;
+        if (journal) checkpoint();
+        return false;
+    }
+    if (remoteOpponent) enemyFleet = remoteFleet();
+    resetStrategy(header.strategySeed);
+    journalSequence = header.journalSequence;
+    // партия заменена целиком, журнал продолжается от нового снимка
+    if (journal) checkpoint();
+    return true;
+}
+
+bool Game::restoreShips(const unsigned char* records, uint64_t count, std::vector<Ship>& ships,
+                        Board& board, FleetStatus& fleet, bool sunkOnly) {
+    ships.reserve(count);
+    uint64_t cells = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        snapshot::ShipRecord record;
+        std::memcpy(&record, records + i * sizeof(record), sizeof(record));
+        ships.emplace_back(record.x, record.y, record.size, record.horizontal != 0, record.hitMask);
+        const Ship& ship = ships.back();
+        uint16_t id = static_cast<uint16_t>(ships.size());
+        for (uint64_t d = 0; d < ship.getSize(); ++d) {
+            uint64_t x = ship.isHorizontal() ? ship.getX() + d : ship.getX();
+            uint64_t y = ship.isHorizontal() ? ship.getY() : ship.getY() + d;
+            CellState state = board.get(x, y);
+            if (state != CellState::SHIP && state != CellState::HIT && state != CellState::KILL) return false;
+            board.setShipId(x, y, id);
+        }
+        cells += ship.getSize();
+        ++fleet.totalShips;
+        if (!ship.isDestroyed()) ++fleet.aliveShips;
+        fleet.aliveCells += ship.getRemaining();
+    }
+    // у удалённого соперника записаны только потопленные корабли, HIT - раненые без записи
+    if (sunkOnly) return board.count(CellState::KILL) == cells;
+    // у каждой клетки с кораблём должен быть ровно один корабль, иначе выстрел
+    // по ней не найдёт, кого ранить
+    return board.count(CellState::SHIP) + board.count(CellState::HIT) + board.count(CellState::KILL) == cells;
+}
+
+bool Game::saveSnapshot(const std::string& path) const {
+    std::string buffer;
+    writeSnapshot(buffer);
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    return file && file.write(buffer.data(), static_cast<std::streamsize>(buffer.size())) && file.flush();
+}
+
+bool Game::loadSnapshot(const std::string& path) {
+    MappedFile file(path);
+    return readSnapshot(file.data(), file.size());
+}
@@ -0,0 +1,79 @@
+#include "../include/Game.hpp"
+
+// Ореол корабля, обрезанный по полю, - тот же прямоугольник, что у markAroundShip.
+// Для кораблей до четырёх палуб в нём не больше 18 клеток, маска помещается в 32 бита.
+void Game::haloRect(const Ship& ship, const Board& board, uint64_t& x0, uint64_t& y0, uint64_t& x1, uint64_t& y1) {
+    x0 = ship.getX() ? ship.getX() - 1 : 0;
+    y0 = ship.getY() ? ship.getY() - 1 : 0;
+    x1 = std::min(ship.getEndX() + 1, board.getWidth() - 1);
+    y1 = std::min(ship.getEndY() + 1, board.getHeight() - 1);
+}
+
+uint32_t Game::emptyHalo(const Ship& ship, const Board& board) const {
+    uint64_t x0, y0, x1, y1;
+    haloRect(ship, board, x0, y0, x1, y1);
+    uint32_t mask = 0;
+    uint32_t bit = 1;
+    for (uint64_t y = y0; y <= y1; ++y) {
+        for (uint64_t x = x0; x <= x1; ++x, bit <<= 1) {
+            if (board.get(x, y) == CellState::EMPTY) mask |= bit;
+        }
+    }
+    return mask;
+}
+
+void Game::undoShot(const ShotUndo& shot) {
+    Board& board = shot.byPlayer ? enemyBoard : myBoard;
+    if (shot.result == ShootResult::MISS) {
+        board.set(shot.x, shot.y, CellState::EMPTY);
+        return;
+    }
+
+    // в корабль стреляли только по целой палубе, поэтому откат обратен hitShip
+    Ship& ship = (shot.byPlayer ? enemyShips : myShips)[shot.shipId - 1];
+    FleetStatus& fleet = shot.byPlayer ? enemyFleet : myFleet;
+    if (shot.result == ShootResult::KILL) {
+        uint64_t x0, y0, x1, y1;
+        haloRect(ship, board, x0, y0, x1, y1);
+        uint32_t bit = 1;
+        for (uint64_t y = y0; y <= y1; ++y) {
+            for (uint64_t x = x0; x <= x1; ++x, bit <<= 1) {
+                if (shot.haloMask & bit) board.set(x, y, CellState::EMPTY);
+            }
+        }
+        board.fillRect(ship.getX(), ship.getY(), ship.getEndX(), ship.getEndY(), CellState::HIT);
+        ++fleet.aliveShips;
+    }
+    ship.undoHit(shot.x, shot.y);
+    ++fleet.aliveCells;
+    board.set(shot.x, shot.y, CellState::SHIP);
+}
+
+UndoPoint Game::mark() {
+    UndoPoint point = {undoLog.size(), version, myTurn, !speculating};
+    speculating = true;
+    return point;
+}
+
+void Game::undo(const UndoPoint& point) {
+    while (undoLog.size() > point.logSize) {
+        undoShot(undoLog.back());
+        undoLog.pop_back();
+    }
+    // пробных версий никто снаружи не видел, их номера можно выдать снова
+    version = point.version;
+    myTurn = point.myTurn;
+    // память журнала остаётся за следующим перебором
+    if (point.outermost) speculating = false;
+}
+
+void Game::commit() {
+    if (!speculating) return;
+    undoLog.clear();
+    speculating = false;
+    // наблюдатель, журнал изменений и стратегия пробных выстрелов не видели:
+    // клиентам нужен полный снимок, стратегия собирается с доски заново
+    markRebuilt();
+    resetStrategy();
+    if (journal) checkpoint();
+}
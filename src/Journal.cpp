@@ -0,0 +1,245 @@
+#include "../include/Journal.hpp"
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+Journal::~Journal() {
+    close();
+}
+
+uint32_t Journal::checksum(const JournalRecord& record) {
+    // три слова и четыре байта до поля суммы; ненулевое начальное значение, чтобы
+    // у нулевого заготовленного хвоста файла сумма не сходилась
+    const uint64_t PRIME = 0x9E3779B97F4A7C15ULL;
+    uint64_t words[3];
+    uint32_t tail;
+    std::memcpy(words, &record, sizeof(words));
+    std::memcpy(&tail, &record.event, sizeof(tail));
+    uint64_t hash = (0x632BE59BD9B4E019ULL ^ tail) * PRIME;
+    for (uint64_t word : words) {
+        hash = (hash ^ (hash >> 29) ^ word) * PRIME;
+    }
+    return static_cast<uint32_t>(hash >> 32);
+}
+
+bool Journal::read(const std::string& path, std::vector<JournalRecord>& records) {
+    records.clear();
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return true;
+    JournalRecord record;
+    while (file.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+        if (record.sequence == 0 || record.checksum != checksum(record)) break;
+        if (!records.empty() && record.sequence != records.back().sequence + 1) break;
+        records.push_back(record);
+    }
+    return true;
+}
+
+#ifdef _WIN32
+
+bool Journal::resize(size_t) {
+    return true;
+}
+
+bool Journal::open(const std::string& path, uint64_t after) {
+    close();
+    std::vector<JournalRecord> records;
+    read(path, records);
+    fd = ::_open(path.c_str(), _O_RDWR | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+    if (fd < 0) return false;
+    used = records.size() * sizeof(JournalRecord);
+    // хвост после последней годной записи - след падения посреди записи
+    if (::_chsize_s(fd, static_cast<long long>(used)) != 0) {
+        close();
+        return false;
+    }
+    uint64_t last = records.empty() ? 0 : records.back().sequence;
+    nextSequence = (last > after ? last : after) + 1;
+    broken = false;
+    stopping = false;
+    syncer = std::thread(&Journal::run, this);
+    return true;
+}
+
+void Journal::close() {
+    if (syncer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        syncer.join();
+    }
+    if (fd < 0) return;
+    sync();
+    ::_close(fd);
+    fd = -1;
+}
+
+uint64_t Journal::append(JournalEvent event, uint64_t x, uint64_t y, uint8_t size, uint8_t horizontal) {
+    if (fd < 0) return 0;
+    JournalRecord record = {};
+    record.sequence = nextSequence++;
+    record.x = x;
+    record.y = y;
+    record.event = event;
+    record.size = size;
+    record.horizontal = horizontal;
+    record.checksum = checksum(record);
+    if (broken) return 0;
+    if (::_write(fd, &record, sizeof(record)) != static_cast<int>(sizeof(record))) {
+        broken = true;
+        return 0;
+    }
+    used += sizeof(record);
+    dirty.store(true, std::memory_order_release);
+    return record.sequence;
+}
+
+void Journal::sync() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fd >= 0 && dirty.exchange(false, std::memory_order_acq_rel)) ::_commit(fd);
+}
+
+bool Journal::clear() {
+    if (fd < 0) return false;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (::_chsize_s(fd, 0) != 0) return false;
+    used = 0;
+    broken = false;
+    dirty.store(true, std::memory_order_release);
+    return true;
+}
+
+#else
+
+bool Journal::resize(size_t bytes) {
+    if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0) return false;
+    if (base) ::munmap(base, capacity);
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    // страницы заводятся сразу, а не первым выстрелом на каждой
+    flags |= MAP_POPULATE;
+#endif
+    void* mapping = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags, fd, 0);
+    base = mapping == MAP_FAILED ? nullptr : static_cast<unsigned char*>(mapping);
+    capacity = base ? bytes : 0;
+    grown = true;
+    return base != nullptr;
+}
+
+bool Journal::open(const std::string& path, uint64_t after) {
+    close();
+    std::vector<JournalRecord> records;
+    read(path, records);
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    used = records.size() * sizeof(JournalRecord);
+    // хвост после последней годной записи - след падения посреди записи; обрезка
+    // и новое удлинение заполняют место под следующие записи нулями
+    if (::ftruncate(fd, static_cast<off_t>(used)) != 0 || !resize(used + GROW_BYTES)) {
+        close();
+        return false;
+    }
+    uint64_t last = records.empty() ? 0 : records.back().sequence;
+    nextSequence = (last > after ? last : after) + 1;
+    written.store(used, std::memory_order_relaxed);
+    synced = used;
+    broken = false;
+    stopping = false;
+    syncer = std::thread(&Journal::run, this);
+    return true;
+}
+
+void Journal::close() {
+    if (syncer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        syncer.join();
+    }
+    if (fd < 0) return;
+    if (base) {
+        ::munmap(base, capacity);
+        base = nullptr;
+        capacity = 0;
+        // заготовленный нулевой хвост на диске не нужен
+        if (::ftruncate(fd, static_cast<off_t>(used)) == 0) ::fsync(fd);
+    }
+    ::close(fd);
+    fd = -1;
+}
+
+uint64_t Journal::append(JournalEvent event, uint64_t x, uint64_t y, uint8_t size, uint8_t horizontal) {
+    if (fd < 0) return 0;
+    JournalRecord record = {};
+    record.sequence = nextSequence++;
+    record.x = x;
+    record.y = y;
+    record.event = event;
+    record.size = size;
+    record.horizontal = horizontal;
+    record.checksum = checksum(record);
+    if (broken) return 0;
+    if (used + sizeof(record) > capacity) {
+        // файл растёт вдвое, так что перестройки отображения редки
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!resize(capacity + (capacity > GROW_BYTES ? capacity : GROW_BYTES))) {
+            broken = true;
+            return 0;
+        }
+    }
+    std::memcpy(base + used, &record, sizeof(record));
+    used += sizeof(record);
+    written.store(used, std::memory_order_release);
+    return record.sequence;
+}
+
+void Journal::sync() {
+    static const size_t PAGE = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t end = written.load(std::memory_order_acquire);
+    if (!base || end <= synced) return;
+    // msync принимает только начало страницы
+    size_t begin = synced & ~(PAGE - 1);
+    ::msync(base + begin, end - begin, MS_SYNC);
+    synced = end;
+    // новый размер файла после удлинения - метаданные, их сбрасывает только fsync
+    if (grown) ::fsync(fd);
+    grown = false;
+}
+
+bool Journal::clear() {
+    // фоновый sync читает отображение и synced под тем же мьютексом
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!base) return false;
+    // старые записи не стираем: новые пишутся поверх с начала, а уцелевший за ними
+    // хвост имеет меньшие номера, и чтение на разрыве останавливается. Страницы
+    // остаются в памяти, и следующие записи не платят за их повторное заведение
+    used = 0;
+    written.store(0, std::memory_order_relaxed);
+    synced = 0;
+    broken = false;
+    return true;
+}
+
+#endif
+
+void Journal::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!wake.wait_for(lock, SYNC_INTERVAL, [this] { return stopping; })) {
+        lock.unlock();
+        sync();
+        lock.lock();
+    }
+}
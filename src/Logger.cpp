@@ -0,0 +1,90 @@
+#include "../include/Logger.hpp"
+#include <cstdio>
+
+Logger::Logger() : slots(new Slot[CAPACITY]) {
+    for (size_t i = 0; i < CAPACITY; ++i) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+Logger::~Logger() {
+    stopping.store(true, std::memory_order_release);
+    if (worker.joinable()) worker.join();
+}
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+bool Logger::parseLevel(std::string_view text, LogLevel& level) {
+    if (text == "debug") level = LogLevel::DEBUG;
+    else if (text == "info") level = LogLevel::INFO;
+    else if (text == "warn") level = LogLevel::WARN;
+    else if (text == "error") level = LogLevel::ERROR;
+    else return false;
+    return true;
+}
+
+void Logger::push(const LogRecord& record) {
+    // поток вывода заводится при первом сообщении
+    std::call_once(started, [this] { worker = std::thread(&Logger::run, this); });
+
+    uint64_t pos = enqueuePos.load(std::memory_order_relaxed);
+    while (true) {
+        Slot& slot = slots[pos & (CAPACITY - 1)];
+        uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(sequence - pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                slot.record = record;
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return;
+            }
+        } else if (diff < 0) {
+            // очередь полна: теряем сообщение, но не ждём
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool Logger::drain() {
+    static const char* const LEVELS[] = {"DEBUG", "INFO ", "WARN ", "ERROR"};
+    bool wrote[2] = {false, false};
+    while (true) {
+        Slot& slot = slots[dequeuePos & (CAPACITY - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != dequeuePos + 1) break;
+
+        const LogRecord& record = slot.record;
+        // время UTC без обращений к часовому поясу
+        int64_t micros = record.time % 86400000000;
+        char line[LogRecord::TEXT_SIZE + 32];
+        int prefix = std::snprintf(line, sizeof(line), "%02d:%02d:%02d.%03d %s ",
+                                   static_cast<int>(micros / 3600000000),
+                                   static_cast<int>(micros / 60000000 % 60),
+                                   static_cast<int>(micros / 1000000 % 60),
+                                   static_cast<int>(micros / 1000 % 1000),
+                                   LEVELS[static_cast<int>(record.level)]);
+        std::memcpy(line + prefix, record.text, record.length);
+        line[prefix + record.length] = '\n';
+        bool error = record.level >= LogLevel::WARN;
+        std::fwrite(line, 1, prefix + record.length + 1, error ? stderr : stdout);
+        wrote[error] = true;
+
+        slot.sequence.store(dequeuePos + CAPACITY, std::memory_order_release);
+        ++dequeuePos;
+    }
+    if (wrote[0]) std::fflush(stdout);
+    if (wrote[1]) std::fflush(stderr);
+    return wrote[0] || wrote[1];
+}
+
+void Logger::run() {
+    while (!stopping.load(std::memory_order_acquire)) {
+        if (!drain()) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    drain();
+}
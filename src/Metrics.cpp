@@ -0,0 +1,142 @@
+#include "../include/Metrics.hpp"
+#include "../include/CommandProcessor.hpp"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+const uint64_t Metrics::BUCKET_BOUNDS_US[Metrics::BUCKET_COUNT - 1] = {
+    1, 2, 5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 100000, 1000000
+};
+
+namespace {
+
+struct HistogramInfo {
+    const char* family;
+    const char* label;
+    std::string_view value;
+};
+
+const char* const COUNTER_NAMES[] = {
+    "sea_battle_player_shots_total",
+    "sea_battle_enemy_shots_total",
+    "sea_battle_placement_attempts_total",
+};
+
+const char* const ROUTE = "sea_battle_http_request_duration_seconds";
+const char* const VERB = "sea_battle_command_duration_seconds";
+const char* const DECISION = "sea_battle_strategy_decision_seconds";
+
+const char* const ROUTES[] = {
+    "/game-state", "/shots", "/ships", "/command", "/changes", "static", "/metrics"
+};
+
+const char* const STRATEGIES[] = {
+    "ordered", "custom", "density", "montecarlo"
+};
+
+static_assert(sizeof(COUNTER_NAMES) / sizeof(COUNTER_NAMES[0]) == static_cast<size_t>(Counter::COUNT));
+
+const size_t VERB_FIRST = static_cast<size_t>(Histogram::VERB_FIRST);
+const size_t VERB_UNKNOWN = static_cast<size_t>(Histogram::VERB_UNKNOWN);
+
+static_assert(sizeof(ROUTES) / sizeof(ROUTES[0]) == VERB_FIRST);
+static_assert(VERB_UNKNOWN - VERB_FIRST == CommandProcessor::VERB_COUNT, "one histogram per command");
+static_assert(VERB_UNKNOWN + 1 + sizeof(STRATEGIES) / sizeof(STRATEGIES[0]) == static_cast<size_t>(Histogram::COUNT));
+
+// семейство и метка гистограммы; команды берутся из таблицы CommandProcessor
+HistogramInfo histogramInfo(size_t histogram) {
+    if (histogram < VERB_FIRST) return {ROUTE, "route", ROUTES[histogram]};
+    if (histogram < VERB_UNKNOWN) return {VERB, "verb", CommandProcessor::VERBS[histogram - VERB_FIRST]};
+    if (histogram == VERB_UNKNOWN) return {VERB, "verb", "unknown"};
+    return {DECISION, "strategy", STRATEGIES[histogram - VERB_UNKNOWN - 1]};
+}
+
+// блоки всех потоков; мьютекс берётся при первом обращении потока и при чтении
+std::mutex registryMutex;
+std::vector<std::unique_ptr<Metrics::ThreadBlock>> registry;
+
+} // namespace
+
+Metrics::ThreadBlock* Metrics::registerThread() {
+    auto block = std::make_unique<ThreadBlock>();
+    for (auto& counter : block->counters) counter.store(0, std::memory_order_relaxed);
+    for (auto& histogram : block->histograms) {
+        for (auto& bucket : histogram.buckets) bucket.store(0, std::memory_order_relaxed);
+        histogram.count.store(0, std::memory_order_relaxed);
+        histogram.sumNanos.store(0, std::memory_order_relaxed);
+    }
+    std::lock_guard<std::mutex> lock(registryMutex);
+    registry.push_back(std::move(block));
+    return registry.back().get();
+}
+
+void Metrics::observe(Histogram histogram, std::chrono::nanoseconds duration) {
+    uint64_t nanos = duration.count() > 0 ? static_cast<uint64_t>(duration.count()) : 0;
+    size_t bucket = 0;
+    while (bucket < BUCKET_COUNT - 1 && nanos > BUCKET_BOUNDS_US[bucket] * 1000) ++bucket;
+    HistogramData& data = local().histograms[static_cast<size_t>(histogram)];
+    bump(data.buckets[bucket], 1);
+    bump(data.count, 1);
+    bump(data.sumNanos, nanos);
+}
+
+Histogram Metrics::commandHistogram(std::string_view command) {
+    size_t index = CommandProcessor::verbIndex(CommandTokens(command).next());
+    return static_cast<Histogram>(VERB_FIRST + index);
+}
+
+std::string Metrics::render() {
+    const size_t COUNTERS = static_cast<size_t>(Counter::COUNT);
+    const size_t HISTOGRAM_COUNT = static_cast<size_t>(Histogram::COUNT);
+    uint64_t counters[COUNTERS] = {};
+    std::vector<uint64_t> buckets(HISTOGRAM_COUNT * BUCKET_COUNT, 0);
+    std::vector<uint64_t> counts(HISTOGRAM_COUNT, 0);
+    std::vector<uint64_t> sums(HISTOGRAM_COUNT, 0);
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const auto& block : registry) {
+            for (size_t c = 0; c < COUNTERS; ++c) {
+                counters[c] += block->counters[c].load(std::memory_order_relaxed);
+            }
+            for (size_t h = 0; h < HISTOGRAM_COUNT; ++h) {
+                const HistogramData& data = block->histograms[h];
+                for (size_t b = 0; b < BUCKET_COUNT; ++b) {
+                    buckets[h * BUCKET_COUNT + b] += data.buckets[b].load(std::memory_order_relaxed);
+                }
+                counts[h] += data.count.load(std::memory_order_relaxed);
+                sums[h] += data.sumNanos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::string out;
+    for (size_t c = 0; c < COUNTERS; ++c) {
+        out += "# TYPE ";
+        out += COUNTER_NAMES[c];
+        out += " counter\n";
+        out += COUNTER_NAMES[c];
+        out += " " + std::to_string(counters[c]) + "\n";
+    }
+
+    const char* family = nullptr;
+    for (size_t h = 0; h < HISTOGRAM_COUNT; ++h) {
+        HistogramInfo info = histogramInfo(h);
+        if (info.family != family) {
+            family = info.family;
+            out += "# TYPE ";
+            out += family;
+            out += " histogram\n";
+        }
+        std::string label = std::string(info.label) + "=\"" + std::string(info.value) + "\"";
+        // корзины в формате Prometheus накопительные
+        uint64_t cumulative = 0;
+        for (size_t b = 0; b < BUCKET_COUNT; ++b) {
+            cumulative += buckets[h * BUCKET_COUNT + b];
+            std::string bound = b + 1 < BUCKET_COUNT ? std::to_string(BUCKET_BOUNDS_US[b] / 1e6) : "+Inf";
+            out += std::string(family) + "_bucket{" + label + ",le=\"" + bound + "\"} " + std::to_string(cumulative) + "\n";
+        }
+        out += std::string(family) + "_sum{" + label + "} " + std::to_string(sums[h] / 1e9) + "\n";
+        out += std::string(family) + "_count{" + label + "} " + std::to_string(counts[h]) + "\n";
+    }
+    return out;
+}
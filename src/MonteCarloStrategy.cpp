@@ -0,0 +1,289 @@
+#include "../include/MonteCarloStrategy.hpp"
+#include "../include/Game.hpp"
+#include <algorithm>
+#include <random>
+
+void MonteCarloStrategy::configure(size_t threads, size_t samples) {
+    threadCount = std::max<size_t>(threads, 1);
+    sampleCount = std::max<size_t>(samples, 1);
+}
+
+void MonteCarloStrategy::reset(const Board& board, const int aliveShips[4], uint64_t seed) {
+    width = board.getWidth();
+    height = board.getHeight();
+    std::copy(aliveShips, aliveShips + 4, alive);
+    awaitingResult = false;
+    hits.clear();
+    // номер выстрела входит в зерно выборок, начинаем со случайного
+    shotNumber = seed;
+
+    cells.assign(width * height, UNKNOWN);
+    board.forEach(CellState::MISS, [&](uint64_t x, uint64_t y) { cells[y * width + x] = BLOCKED; });
+    board.forEach(CellState::KILL, [&](uint64_t x, uint64_t y) { cells[y * width + x] = BLOCKED; });
+    board.forEach(CellState::HIT, [&](uint64_t x, uint64_t y) {
+        cells[y * width + x] = HIT;
+        hits.push_back(y * width + x);
+    });
+    fallback.reset(board, aliveShips, seed);
+}
+
+std::vector<std::vector<MonteCarloStrategy::Placement>> MonteCarloStrategy::groupPlacements() const {
+    std::vector<std::vector<Placement>> groups;
+    std::vector<bool> grouped(hits.size(), false);
+
+    for (size_t first = 0; first < hits.size(); ++first) {
+        if (grouped[first]) continue;
+
+        // связная по сторонам группа попаданий - один раненый корабль
+        std::vector<uint64_t> group{hits[first]};
+        grouped[first] = true;
+        for (size_t i = 0; i < group.size(); ++i) {
+            for (size_t j = 0; j < hits.size(); ++j) {
+                uint64_t a = group[i], b = hits[j];
+                bool adjacent = (a / width == b / width && (a + 1 == b || b + 1 == a))
+                             || a + width == b || b + width == a;
+                if (!grouped[j] && adjacent) {
+                    grouped[j] = true;
+                    group.push_back(b);
+                }
+            }
+        }
+
+        uint64_t minX = width, minY = height, maxX = 0, maxY = 0;
+        for (uint64_t cell : group) {
+            minX = std::min(minX, cell % width);
+            maxX = std::max(maxX, cell % width);
+            minY = std::min(minY, cell / width);
+            maxY = std::max(maxY, cell / width);
+        }
+
+        std::vector<Placement> candidates;
+        if (minX == maxX || minY == maxY) {
+            int groupLength = static_cast<int>(std::max(maxX - minX, maxY - minY) + 1);
+            for (int size = groupLength; size <= 4; ++size) {
+                if (alive[size - 1] <= 0) continue;
+                for (int dir = 0; dir < (size > 1 ? 2 : 1); ++dir) {
+                    bool horizontal = dir == 0;
+                    if (groupLength > 1 && horizontal != (minY == maxY)) continue;
+
+                    uint64_t from = horizontal ? minX : minY;
+                    uint64_t to = horizontal ? maxX : maxY;
+                    uint64_t lowest = (to + 1 >= static_cast<uint64_t>(size)) ? to + 1 - size : 0;
+                    for (uint64_t start = lowest; start <= from; ++start) {
+                        Placement p{horizontal ? start : minX, horizontal ? minY : start, size, horizontal};
+                        uint64_t endX = horizontal ? p.x + size - 1 : p.x;
+                        uint64_t endY = horizontal ? p.y : p.y + size - 1;
+                        if (endX >= width || endY >= height) continue;
+
+                        bool legal = true;
+                        for (uint64_t cy = (p.y ? p.y - 1 : 0); cy <= std::min(endY + 1, height - 1) && legal; ++cy) {
+                            for (uint64_t cx = (p.x ? p.x - 1 : 0); cx <= std::min(endX + 1, width - 1); ++cx) {
+                                bool inside = cx >= p.x && cx <= endX && cy >= p.y && cy <= endY;
+                                uint8_t state = cells[cy * width + cx];
+                                if ((inside && state == BLOCKED) || (!inside && state == HIT)) {
+                                    legal = false;
+                                    break;
+                                }
+                            }
+                        }
+                        if (legal) candidates.push_back(p);
+                    }
+                }
+            }
+        }
+        groups.push_back(std::move(candidates));
+    }
+    return groups;
+}
+
+bool MonteCarloStrategy::fits(const Worker& worker, const Placement& p) const {
+    if (p.horizontal ? p.x + p.size > width : p.y + p.size > height) return false;
+    uint64_t step = p.horizontal ? 1 : width;
+    uint64_t cell = p.y * width + p.x;
+    for (int i = 0; i < p.size; ++i, cell += step) {
+        if (cells[cell] == BLOCKED || worker.stamps[cell] == worker.stamp) return false;
+    }
+    return true;
+}
+
+void MonteCarloStrategy::occupy(Worker& worker, const Placement& p) const {
+    // корабль и ореол помечаются текущей меткой выборки
+    uint64_t endX = p.horizontal ? p.x + p.size - 1 : p.x;
+    uint64_t endY = p.horizontal ? p.y : p.y + p.size - 1;
+    for (uint64_t cy = (p.y ? p.y - 1 : 0); cy <= std::min(endY + 1, height - 1); ++cy) {
+        for (uint64_t cx = (p.x ? p.x - 1 : 0); cx <= std::min(endX + 1, width - 1); ++cx) {
+            worker.stamps[cy * width + cx] = worker.stamp;
+        }
+    }
+}
+
+void MonteCarloStrategy::sample(Worker& worker, size_t samples,
+                                const std::vector<std::vector<Placement>>& groups, ShotDeadline deadline) const {
+    std::mt19937_64 gen(worker.seed);
+    std::uniform_int_distribution<uint64_t> disX(0, width - 1);
+    std::uniform_int_distribution<uint64_t> disY(0, height - 1);
+    std::bernoulli_distribution disDir(0.5);
+    const int MAX_ATTEMPTS = 100;
+    // часы опрашиваются раз в пачку выборок, а не на каждой
+    const size_t DEADLINE_CHECK = 4;
+    bool timed = deadline != ShotDeadline::max();
+
+    std::vector<Placement> fleet;
+    for (size_t s = 0; s < samples; ++s) {
+        if (timed && s % DEADLINE_CHECK == 0 && std::chrono::steady_clock::now() >= deadline) break;
+        if (++worker.stamp == 0) {
+            std::fill(worker.stamps.begin(), worker.stamps.end(), 0);
+            worker.stamp = 1;
+        }
+
+        int remaining[4];
+        std::copy(alive, alive + 4, remaining);
+        fleet.clear();
+        bool ok = true;
+
+        // сначала раненые корабли: каждая группа попаданий накрывается целиком
+        for (const auto& candidates : groups) {
+            ok = false;
+            if (candidates.empty()) break;
+            size_t offset = gen() % candidates.size();
+            for (size_t i = 0; i < candidates.size(); ++i) {
+                const Placement& p = candidates[(offset + i) % candidates.size()];
+                if (remaining[p.size - 1] > 0 && fits(worker, p)) {
+                    occupy(worker, p);
+                    fleet.push_back(p);
+                    --remaining[p.size - 1];
+                    ok = true;
+                    break;
+                }
+            }
+            if (!ok) break;
+        }
+
+        for (int size = 4; size > 0 && ok; --size) {
+            for (int n = 0; n < remaining[size - 1] && ok; ++n) {
+                ok = false;
+                for (int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt) {
+                    Placement p{disX(gen), disY(gen), size, size > 1 && disDir(gen)};
+                    if (fits(worker, p)) {
+                        occupy(worker, p);
+                        fleet.push_back(p);
+                        ok = true;
+                        break;
+                    }
+                }
+            }
+        }
+        if (!ok) continue;
+
+        for (const auto& p : fleet) {
+            uint64_t step = p.horizontal ? 1 : width;
+            uint64_t cell = p.y * width + p.x;
+            for (int i = 0; i < p.size; ++i, cell += step) {
+                ++worker.counts[cell];
+            }
+        }
+    }
+}
+
+std::pair<uint64_t, uint64_t> MonteCarloStrategy::nextShot(const Board& board, ShotDeadline deadline) {
+    if (width == 0 || height == 0) return {0, 0};
+
+    // ответа на прошлый выстрел не было - результат неизвестен, расстановки не режем
+    if (awaitingResult && cells[lastShot] == UNKNOWN) {
+        cells[lastShot] = PENDING;
+    }
+
+    uint64_t total = width * height;
+    // hardware_concurrency может вернуть 0
+    size_t tasks = std::max<size_t>(threadCount, 1);
+    workers.resize(tasks);
+    ++shotNumber;
+    for (size_t i = 0; i < tasks; ++i) {
+        Worker& worker = workers[i];
+        worker.counts.assign(total, 0);
+        if (worker.stamps.size() != total) {
+            worker.stamps.assign(total, 0);
+            worker.stamp = 0;
+        }
+        worker.seed = shotNumber * 0x9E3779B97F4A7C15ULL + i;
+    }
+
+    auto groups = groupPlacements();
+    size_t share = sampleCount / tasks;
+    size_t extra = sampleCount % tasks;
+    auto run = [&](size_t task) {
+        sample(workers[task], share + (task < extra ? 1 : 0), groups, deadline);
+    };
+    if (tasks == 1) {
+        // одна задача - без очереди к общему пулу
+        run(0);
+    } else {
+        ThreadPool::shared().parallelFor(tasks, run);
+    }
+
+    uint64_t best = total;
+    uint64_t bestScore = 0;
+    for (uint64_t cell = 0; cell < total; ++cell) {
+        if (cells[cell] != UNKNOWN) continue;
+        uint64_t score = 0;
+        for (const auto& worker : workers) {
+            score += worker.counts[cell];
+        }
+        if (best == total || score > bestScore) {
+            best = cell;
+            bestScore = score;
+        }
+    }
+
+    if (best == total) return {0, 0};
+    if (bestScore == 0) {
+        // флот слишком плотный для случайной расстановки или у группы попаданий нет
+        // расстановок: все счётчики нули, и первая неизвестная клетка ничем не лучше
+        auto [x, y] = fallback.nextShot(board, deadline);
+        if (x < width && y < height && cells[y * width + x] == UNKNOWN) best = y * width + x;
+    }
+    awaitingResult = true;
+    lastShot = best;
+    return {best % width, best / width};
+}
+
+void MonteCarloStrategy::onShot(uint64_t x, uint64_t y, ShootResult result, const Ship* killed) {
+    if (x >= width || y >= height) return;
+    awaitingResult = false;
+    fallback.onShot(x, y, result, killed);
+    uint64_t cell = y * width + x;
+
+    switch (result) {
+        case ShootResult::MISS:
+            cells[cell] = BLOCKED;
+            break;
+        case ShootResult::HIT:
+            if (cells[cell] == UNKNOWN || cells[cell] == PENDING) {
+                cells[cell] = HIT;
+                hits.push_back(cell);
+            }
+            break;
+        case ShootResult::KILL: {
+            if (!killed) {
+                cells[cell] = BLOCKED;
+                break;
+            }
+            if (alive[killed->getSize() - 1] > 0) --alive[killed->getSize() - 1];
+            hits.erase(std::remove_if(hits.begin(), hits.end(), [&](uint64_t h) {
+                return killed->containsPosition(h % width, h / width);
+            }), hits.end());
+
+            // корабль и ореол вокруг него
+            uint64_t toX = std::min(killed->getEndX() + 1, width - 1);
+            uint64_t toY = std::min(killed->getEndY() + 1, height - 1);
+            for (uint64_t cy = (killed->getY() ? killed->getY() - 1 : 0); cy <= toY; ++cy) {
+                for (uint64_t cx = (killed->getX() ? killed->getX() - 1 : 0); cx <= toX; ++cx) {
+                    cells[cy * width + cx] = BLOCKED;
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
@@ -0,0 +1,26 @@
+#include "../include/OrderedStrategy.hpp"
+
+void OrderedStrategy::reset(const Board&, const int[4], uint64_t) {
+    nextX = 0;
+    nextY = 0;
+}
+
+std::pair<uint64_t, uint64_t> OrderedStrategy::nextShot(const Board& board, ShotDeadline) {
+    while (nextY < board.getHeight()) {
+        while (nextX < board.getWidth()) {
+            CellState state = board.get(nextX, nextY);
+            if (state == CellState::EMPTY || state == CellState::SHIP) {
+                uint64_t x = nextX++;
+                return {x, nextY};
+            }
+            nextX++;
+        }
+        nextX = 0;
+        nextY++;
+    }
+    return {0, 0};
+}
+
+void OrderedStrategy::onShot(uint64_t, uint64_t, ShootResult, const Ship*) {
+    // курсор уже сдвинут, результат выстрела на порядок обхода не влияет
+}
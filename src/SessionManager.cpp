@@ -0,0 +1,78 @@
+#include "../include/SessionManager.hpp"
+#include <random>
+
+void Session::publish(std::string event) {
+    auto shared = std::make_shared<const std::string>(std::move(event));
+    for (auto it = subscribers.begin(); it != subscribers.end();) {
+        if (auto subscriber = it->lock()) {
+            subscriber->deliver(shared);
+            ++it;
+        } else {
+            it = subscribers.erase(it);
+        }
+    }
+}
+
+std::string SessionManager::generateId() {
+    // 128 случайных бит: идентификатор нельзя угадать по соседним сессиям
+    thread_local std::mt19937_64 gen{std::random_device{}()};
+    static const char HEX[] = "0123456789abcdef";
+    std::string id(32, '0');
+    for (int half = 0; half < 2; ++half) {
+        uint64_t bits = gen();
+        for (int i = 0; i < 16; ++i, bits >>= 4) {
+            id[half * 16 + i] = HEX[bits & 15];
+        }
+    }
+    return id;
+}
+
+std::shared_ptr<Session> SessionManager::find(const std::string& id) {
+    Shard& shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.sessions.find(id);
+    if (it == shard.sessions.end()) return nullptr;
+    it->second->touch();
+    return it->second;
+}
+
+std::shared_ptr<Session> SessionManager::create(std::string& id) {
+    auto session = std::make_shared<Session>(ioc);
+    session->touch();
+    while (true) {
+        id = generateId();
+        Shard& shard = shardFor(id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.sessions.emplace(id, session).second) break;
+    }
+    count.fetch_add(1, std::memory_order_relaxed);
+    return session;
+}
+
+std::shared_ptr<Session> SessionManager::acquire(std::string& id, bool& created) {
+    created = false;
+    if (!id.empty()) {
+        if (auto session = find(id)) return session;
+    }
+    created = true;
+    return create(id);
+}
+
+size_t SessionManager::expire(std::chrono::steady_clock::duration idle) {
+    int64_t deadline = (std::chrono::steady_clock::now() - idle).time_since_epoch().count();
+    size_t removed = 0;
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto it = shard.sessions.begin(); it != shard.sessions.end();) {
+            // запрос, уже взявший сессию, держит свою ссылку и доработает с ней
+            if (it->second->lastAccess.load(std::memory_order_relaxed) < deadline) {
+                it = shard.sessions.erase(it);
+                ++removed;
+            } else {
+                ++it;
+            }
+        }
+    }
+    count.fetch_sub(removed, std::memory_order_relaxed);
+    return removed;
+}
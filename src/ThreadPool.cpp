@@ -0,0 +1,86 @@
+#include "../include/ThreadPool.hpp"
+
+ThreadPool::ThreadPool(size_t threads) {
+    // вызывающий поток тоже работает, поэтому рабочих на один меньше
+    size_t count = threads > 1 ? threads - 1 : 0;
+    workers.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::runTasks(const std::function<void(size_t)>& fn, size_t count) {
+    for (size_t task = nextTask.fetch_add(1); task < count; task = nextTask.fetch_add(1)) {
+        fn(task);
+    }
+}
+
+void ThreadPool::workerLoop() {
+    uint64_t seen = 0;
+    while (true) {
+        const std::function<void(size_t)>* current;
+        size_t count;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeUp.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            // проснулись после того, как задачу уже доделали без нас
+            if (!job) continue;
+            current = job;
+            count = jobSize;
+            ++activeWorkers;
+        }
+
+        runTasks(*current, count);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --activeWorkers;
+        }
+        finished.notify_one();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& fn) {
+    if (count == 0) return;
+    // один parallelFor за раз: общим пулом пользуются все партии процесса
+    std::lock_guard<std::mutex> call(callMutex);
+
+    if (workers.empty() || count == 1) {
+        for (size_t task = 0; task < count; ++task) fn(task);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &fn;
+        jobSize = count;
+        nextTask.store(0);
+        ++generation;
+    }
+    wakeUp.notify_all();
+
+    runTasks(fn, count);
+
+    // ждём, пока все рабочие, взявшие эту задачу, закончат
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&] { return activeWorkers == 0; });
+    job = nullptr;
+}
@@ -0,0 +1,266 @@
+#include "../include/Game.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Турнир без вывода: две стратегии добивают одинаковые флоты по очереди
+// (попал - стреляешь снова), побеждает первая, потопившая всё. Каждый поток
+// держит свою пару Game и берёт номера партий пачками из общего счётчика.
+
+namespace {
+
+struct TournamentConfig {
+    std::string strategies[2];
+    uint64_t games = 10000;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t width = 10;
+    uint64_t height = 10;
+    uint64_t ships[4] = {2, 2, 2, 1};
+    uint64_t seed = 1;
+    uint64_t samples = 500;
+    // срок на выстрел в мс, 0 - без ограничения
+    uint64_t timeLimit = 0;
+    bool histogram = false;
+};
+
+struct TournamentStats {
+    uint64_t wins[2] = {0, 0};
+    uint64_t forfeits[2] = {0, 0};
+    // партии, где генератор не смог расставить флот
+    uint64_t skipped = 0;
+    // shotsToWin[side][n] - число побед стороны ровно за n выстрелов
+    std::vector<uint64_t> shotsToWin[2];
+
+    void merge(const TournamentStats& other) {
+        skipped += other.skipped;
+        for (int side = 0; side < 2; ++side) {
+            wins[side] += other.wins[side];
+            forfeits[side] += other.forfeits[side];
+            auto& mine = shotsToWin[side];
+            const auto& theirs = other.shotsToWin[side];
+            if (mine.size() < theirs.size()) mine.resize(theirs.size(), 0);
+            for (size_t n = 0; n < theirs.size(); ++n) mine[n] += theirs[n];
+        }
+    }
+};
+
+const uint64_t BATCH = 64;
+
+bool setupPlayer(Game& game, const TournamentConfig& config, int side) {
+    if (!game.createGame("slave")) return false;
+    if (!game.setWidth(config.width) || !game.setHeight(config.height)) return false;
+    for (int size = 1; size <= 4; ++size) {
+        if (!game.setShipCount(size, config.ships[size - 1])) return false;
+    }
+    // партий одновременно столько же, сколько ядер - Монте-Карло считает в своём потоке
+    game.setMonteCarloOptions(1, config.samples);
+    if (!game.setTimeLimit(config.timeLimit)) return false;
+    return game.setStrategy(config.strategies[side]);
+}
+
+void playMatch(Game (&players)[2], uint64_t index, const TournamentConfig& config, TournamentStats& stats) {
+    for (auto& player : players) {
+        // одинаковое зерно - одинаковая расстановка у обеих сторон
+        player.setSeed(config.seed + index);
+        if (!player.startGame()) {
+            ++stats.skipped;
+            return;
+        }
+    }
+
+    uint64_t limit = config.width * config.height;
+    uint64_t shots[2] = {0, 0};
+    int shooter = static_cast<int>(index & 1);
+    while (true) {
+        Game& game = players[shooter];
+        auto [x, y] = game.getNextShot();
+        ShootResult result = game.processEnemyShot(x, y);
+        ++shots[shooter];
+
+        // неверный выстрел или зацикливание - техническое поражение
+        if (result == ShootResult::INVALID || shots[shooter] > limit) {
+            ++stats.forfeits[shooter];
+            ++stats.wins[shooter ^ 1];
+            return;
+        }
+        if (game.isLoser()) {
+            ++stats.wins[shooter];
+            ++stats.shotsToWin[shooter][shots[shooter]];
+            return;
+        }
+        if (result == ShootResult::MISS) shooter ^= 1;
+    }
+}
+
+void runWorker(const TournamentConfig& config, std::atomic<uint64_t>& nextGame,
+               TournamentStats& stats, std::atomic<bool>& failed) {
+    Game players[2];
+    for (int side = 0; side < 2; ++side) {
+        if (!setupPlayer(players[side], config, side)) {
+            failed = true;
+            return;
+        }
+        stats.shotsToWin[side].assign(config.width * config.height + 1, 0);
+    }
+
+    while (true) {
+        uint64_t first = nextGame.fetch_add(BATCH);
+        if (first >= config.games) break;
+        uint64_t last = std::min(first + BATCH, config.games);
+        for (uint64_t index = first; index < last; ++index) {
+            playMatch(players, index, config, stats);
+        }
+    }
+}
+
+uint64_t percentile(const std::vector<uint64_t>& histogram, uint64_t total, double fraction) {
+    uint64_t target = static_cast<uint64_t>(fraction * (total - 1));
+    uint64_t seen = 0;
+    for (size_t n = 0; n < histogram.size(); ++n) {
+        seen += histogram[n];
+        if (seen > target) return n;
+    }
+    return 0;
+}
+
+void printSide(const TournamentConfig& config, const TournamentStats& stats, int side) {
+    uint64_t played = stats.wins[0] + stats.wins[1];
+    const auto& histogram = stats.shotsToWin[side];
+    uint64_t counted = 0;
+    uint64_t sum = 0;
+    for (size_t n = 0; n < histogram.size(); ++n) {
+        counted += histogram[n];
+        sum += histogram[n] * n;
+    }
+
+    std::cout << config.strategies[side] << ": wins " << stats.wins[side] << " ("
+              << std::fixed << std::setprecision(2) << (played ? 100.0 * stats.wins[side] / played : 0.0) << "%)"
+              << ", forfeits " << stats.forfeits[side] << std::endl;
+    if (counted == 0) return;
+
+    std::cout << "  shots to win: mean " << std::setprecision(2) << static_cast<double>(sum) / counted
+              << ", p10 " << percentile(histogram, counted, 0.10)
+              << ", p50 " << percentile(histogram, counted, 0.50)
+              << ", p90 " << percentile(histogram, counted, 0.90)
+              << ", max " << percentile(histogram, counted, 1.0) << std::endl;
+
+    if (config.histogram) {
+        for (size_t n = 0; n < histogram.size(); ++n) {
+            if (histogram[n]) std::cout << "  " << n << " " << histogram[n] << std::endl;
+        }
+    }
+}
+
+void printUsage() {
+    std::cerr << "Usage: tournament <strategyA> <strategyB> [games] [threads]\n"
+              << "       [--size <width> <height>] [--ships <1> <2> <3> <4>]\n"
+              << "       [--seed <n>] [--samples <n>] [--timelimit <ms>] [--histogram]\n"
+              << "Strategies: ordered, custom, density, montecarlo\n";
+}
+
+bool parseNumber(const char* text, uint64_t& value) {
+    char* end = nullptr;
+    value = std::strtoull(text, &end, 10);
+    return end != text && *end == '\0';
+}
+
+bool parseArgs(int argc, char** argv, TournamentConfig& config) {
+    if (argc < 3) return false;
+    config.strategies[0] = argv[1];
+    config.strategies[1] = argv[2];
+
+    int positional = 0;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        uint64_t value;
+        if (arg == "--size" && i + 2 < argc) {
+            if (!parseNumber(argv[++i], config.width) || !parseNumber(argv[++i], config.height)) return false;
+        } else if (arg == "--ships" && i + 4 < argc) {
+            for (auto& count : config.ships) {
+                if (!parseNumber(argv[++i], count)) return false;
+            }
+        } else if (arg == "--seed" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], config.seed)) return false;
+        } else if (arg == "--samples" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], config.samples) || config.samples == 0) return false;
+        } else if (arg == "--timelimit" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], config.timeLimit)) return false;
+        } else if (arg == "--histogram") {
+            config.histogram = true;
+        } else if (positional == 0 && parseNumber(argv[i], value)) {
+            config.games = value;
+            ++positional;
+        } else if (positional == 1 && parseNumber(argv[i], value) && value > 0) {
+            config.threads = value;
+            ++positional;
+        } else {
+            return false;
+        }
+    }
+    // гистограмма выстрелов заводится на каждую клетку
+    return config.games > 0 && Board::fitsDense(config.width, config.height);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    TournamentConfig config;
+    if (!parseArgs(argc, argv, config)) {
+        printUsage();
+        return 1;
+    }
+    config.threads = std::min<uint64_t>(config.threads, (config.games + BATCH - 1) / BATCH);
+
+    // конфигурацию проверяем один раз до запуска потоков
+    Game probe;
+    if (!setupPlayer(probe, config, 0) || !setupPlayer(probe, config, 1)) {
+        std::cerr << "Invalid tournament configuration" << std::endl;
+        printUsage();
+        return 1;
+    }
+    if (!probe.startGame()) {
+        std::cerr << "Failed to start game: " << probe.getSetupError() << std::endl;
+        return 1;
+    }
+
+    std::vector<TournamentStats> stats(config.threads);
+    std::vector<std::thread> threads;
+    std::atomic<uint64_t> nextGame{0};
+    std::atomic<bool> failed{false};
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < config.threads; ++i) {
+        threads.emplace_back(runWorker, std::cref(config), std::ref(nextGame), std::ref(stats[i]), std::ref(failed));
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (failed) {
+        std::cerr << "Failed to set up players" << std::endl;
+        return 1;
+    }
+
+    TournamentStats total;
+    for (const auto& part : stats) {
+        total.merge(part);
+    }
+
+    std::cout << config.strategies[0] << " vs " << config.strategies[1] << ", " << config.games << " games on "
+              << config.width << "x" << config.height << ", ships " << config.ships[0] << " " << config.ships[1]
+              << " " << config.ships[2] << " " << config.ships[3] << ", " << config.threads << " threads" << std::endl;
+    printSide(config, total, 0);
+    printSide(config, total, 1);
+    if (total.skipped) {
+        std::cout << "Skipped " << total.skipped << " games: fleet could not be placed" << std::endl;
+    }
+    std::cout << "Elapsed " << std::setprecision(3) << seconds << " s, "
+              << std::setprecision(0) << config.games / seconds << " games/s" << std::endl;
+    return 0;
+}
@@ -2,44 +2,327 @@
 #include <boost/beast/http.hpp>
 #include <boost/beast/version.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/write.hpp>
 #include <boost/config.hpp>
 #include <boost/json.hpp>
-#include <iostream>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <deque>
+#include <cstdlib>
 #include <memory>
+#include <optional>
 #include <string>
 #include <thread>
-#include <fstream>
-#include <sstream>
 #include <filesystem>
+#include <string_view>
+#include <vector>
 #include "Game.hpp"
 #include "CommandProcessor.hpp"
+#include "SessionManager.hpp"
+#include "AssetCache.hpp"
+#include "Logger.hpp"
+#include "Metrics.hpp"
 
 namespace beast = boost::beast;
 namespace http = beast::http;
 namespace net = boost::asio;
 using tcp = boost::asio::ip::tcp;
 
+// сессия берётся из cookie, клиенты без cookie могут передать заголовок
+static const std::string SESSION_COOKIE = "session";
+static const char* const SESSION_HEADER = "X-Session-Id";
+
+// Неизменные поля заголовков для каждого вида ответа собраны заранее
+// и дописываются к строке статуса одним куском.
+#define SERVER_FIELD "Server: " BOOST_BEAST_VERSION_STRING "\r\n"
+static constexpr std::string_view API_FIELDS =
+    SERVER_FIELD
+    "Access-Control-Allow-Origin: *\r\n"
+    "Access-Control-Allow-Methods: GET, POST, OPTIONS\r\n"
+    "Access-Control-Allow-Headers: Content-Type, X-Session-Id\r\n";
+static constexpr std::string_view ASSET_FIELDS =
+    SERVER_FIELD
+    // браузер хранит файл, но сверяет ETag при каждой загрузке страницы
+    "Cache-Control: no-cache\r\n"
+    "Vary: Accept-Encoding\r\n"
+    "Access-Control-Allow-Origin: *\r\n";
+static constexpr std::string_view ERROR_FIELDS =
+    SERVER_FIELD
+    "Content-Type: text/plain\r\n"
+    "Cache-Control: no-store, no-cache, must-revalidate, max-age=0\r\n"
+    "Pragma: no-cache\r\n";
+static constexpr std::string_view METRICS_FIELDS =
+    SERVER_FIELD
+    "Content-Type: text/plain; version=0.0.4\r\n"
+    "Cache-Control: no-store\r\n";
+#undef SERVER_FIELD
+
+static const char* shot_result_name(ShootResult result) {
+    switch (result) {
+        case ShootResult::MISS: return "miss";
+        case ShootResult::HIT: return "hit";
+        case ShootResult::KILL: return "kill";
+        default: return "invalid";
+    }
+}
+
+// событие SSE: имя и JSON одной строкой data
+static std::string make_event(const char* name, const boost::json::object& data) {
+    return std::string("event: ") + name + "\ndata: " + boost::json::serialize(data) + "\n\n";
+}
+
+static std::string make_shot_event(const ShotEvent& shot) {
+    boost::json::object data;
+    data["shooter"] = shot.byPlayer ? "player" : "enemy";
+    data["x"] = shot.x;
+    data["y"] = shot.y;
+    data["result"] = shot_result_name(shot.result);
+    data["version"] = shot.version;
+    if (shot.killed) {
+        // клиент сам отмечает корабль и ореол вокруг него
+        boost::json::object ship;
+        ship["x"] = shot.killed->getX();
+        ship["y"] = shot.killed->getY();
+        ship["size"] = shot.killed->getSize();
+        ship["horizontal"] = shot.killed->isHorizontal();
+        data["ship"] = ship;
+    }
+    return make_event("shot", data);
+}
+
+// Двоичный снимок /game-state для клиентов с Accept: application/octet-stream.
+// Числа little-endian: "SBS1", u64 version, u64 width, u64 height, u8 флаги
+// (1 - партия окончена, 2 - победил игрок, 4 - поле разреженное, клеток нет),
+// затем поле игрока и поле противника по строкам отрезками одинаковых клеток:
+// байт = состояние (3 бита) | младшие 4 бита (длина - 1) << 3 | 0x80, если
+// остальные биты длины идут следом в LEB128.
+static const char SNAPSHOT_MAGIC[] = "SBS1";
+
+static void put_u64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+static void put_run(std::string& out, CellState state, uint64_t length) {
+    uint64_t rest = length - 1;
+    uint8_t head = static_cast<uint8_t>(state) | static_cast<uint8_t>((rest & 15) << 3);
+    rest >>= 4;
+    out.push_back(static_cast<char>(head | (rest ? 0x80 : 0)));
+    while (rest) {
+        uint8_t low = rest & 0x7f;
+        rest >>= 7;
+        out.push_back(static_cast<char>(low | (rest ? 0x80 : 0)));
+    }
+}
+
+static void put_board_runs(std::string& out, const Board& board) {
+    CellState current = CellState::EMPTY;
+    uint64_t length = 0;
+    for (uint64_t y = 0; y < board.getHeight(); ++y) {
+        for (uint64_t x = 0; x < board.getWidth(); ++x) {
+            CellState state = board.get(x, y);
+            if (length && state == current) {
+                ++length;
+                continue;
+            }
+            if (length) put_run(out, current, length);
+            current = state;
+            length = 1;
+        }
+    }
+    if (length) put_run(out, current, length);
+}
+
+static void write_binary_snapshot(std::string& out, const Game& game) {
+    const Board& myBoard = game.getPlayerBoard();
+    out.assign(SNAPSHOT_MAGIC, 4);
+    put_u64(out, game.getVersion());
+    put_u64(out, myBoard.getWidth());
+    put_u64(out, myBoard.getHeight());
+    uint8_t flags = (game.isFinished() ? 1 : 0) | (game.isWinner() ? 2 : 0) | (myBoard.isSparse() ? 4 : 0);
+    out.push_back(static_cast<char>(flags));
+    if (!myBoard.isSparse()) {
+        put_board_runs(out, myBoard);
+        put_board_runs(out, game.getEnemyBoard());
+    }
+}
+
+// значение параметра name из строки запроса a=1&b=2, пустое, если его нет
+static std::string_view query_param(std::string_view query, std::string_view name) {
+    while (!query.empty()) {
+        std::string_view pair = query.substr(0, query.find('&'));
+        query.remove_prefix(std::min(query.size(), pair.size() + 1));
+        if (pair.size() > name.size() && pair.substr(0, name.size()) == name && pair[name.size()] == '=') {
+            return pair.substr(name.size() + 1);
+        }
+    }
+    return {};
+}
+
+static void add_game_over(boost::json::object& data, const Game& game) {
+    data["gameOver"] = game.isFinished();
+    if (game.isFinished()) {
+        data["winner"] = game.isWinner() ? "player" : "enemy";
+    }
+}
+
+static std::string make_state_event(const std::string& command, const std::string& response, const Game& game) {
+    boost::json::object data;
+    data["command"] = command;
+    data["response"] = response;
+    add_game_over(data, game);
+    return make_event("state", data);
+}
+
+// Поток Server-Sent Events одной сессии. Забирает tcp_stream у http_connection
+// и дальше только пишет; чтение нужно лишь для того, чтобы заметить закрытие.
+class event_stream : public SessionSubscriber, public std::enable_shared_from_this<event_stream> {
+    // клиент, который не успевает читать, отключается и после переподключения
+    // забирает состояние целиком
+    static const size_t MAX_QUEUE = 1024;
+
+    beast::tcp_stream stream_;
+    std::shared_ptr<Session> session_;
+    net::steady_timer heartbeat_;
+    std::deque<std::shared_ptr<const std::string>> queue_;
+    char read_buffer_[64];
+    bool closed_ = false;
+
+public:
+    event_stream(beast::tcp_stream&& stream, std::shared_ptr<Session> session)
+        : stream_(std::move(stream))
+        , session_(std::move(session))
+        , heartbeat_(stream_.get_executor()) {}
+
+    // header - заголовок HTTP-ответа, уходит первым
+    void start(std::string header) {
+        stream_.expires_never();
+        enqueue(std::make_shared<const std::string>(std::move(header)));
+        read_until_closed();
+        schedule_heartbeat();
+    }
+
+    void deliver(std::shared_ptr<const std::string> event) override {
+        net::post(stream_.get_executor(), [self = shared_from_this(), event = std::move(event)]() mutable {
+            self->enqueue(std::move(event));
+        });
+    }
+
+private:
+    void enqueue(std::shared_ptr<const std::string> event) {
+        if (closed_) return;
+        if (queue_.size() >= MAX_QUEUE) return close();
+        queue_.push_back(std::move(event));
+        if (queue_.size() == 1) write_next();
+    }
+
+    void write_next() {
+        net::async_write(
+            stream_,
+            net::buffer(*queue_.front()),
+            [self = shared_from_this()](beast::error_code ec, std::size_t) {
+                if (ec) return self->close();
+                self->queue_.pop_front();
+                if (!self->queue_.empty()) self->write_next();
+            });
+    }
+
+    void read_until_closed() {
+        stream_.async_read_some(
+            net::buffer(read_buffer_),
+            [self = shared_from_this()](beast::error_code ec, std::size_t) {
+                if (ec) return self->close();
+                self->read_until_closed();
+            });
+    }
+
+    // комментарий раз в 15 секунд не даёт прокси закрыть поток и продлевает сессию
+    void schedule_heartbeat() {
+        heartbeat_.expires_after(std::chrono::seconds(15));
+        heartbeat_.async_wait([self = shared_from_this()](beast::error_code ec) {
+            if (ec || self->closed_) return;
+            self->session_->touch();
+            static const auto ping = std::make_shared<const std::string>(": ping\n\n");
+            self->enqueue(ping);
+            self->schedule_heartbeat();
+        });
+    }
+
+    void close() {
+        if (closed_) return;
+        closed_ = true;
+        heartbeat_.cancel();
+        beast::error_code ec;
+        stream_.socket().shutdown(tcp::socket::shutdown_both, ec);
+        stream_.close();
+    }
+};
+
+// Ответ API, который соединение переиспользует от запроса к запросу: тело
+// и стек сериализатора сохраняют ёмкость, а DOM ответа строится в арене
+// соединения. После первых запросов ответ собирается без выделений памяти.
+struct api_reply {
+    // DOM обычной партии помещается целиком, большие поля добирают память из кучи
+    static const size_t ARENA_SIZE = 16 * 1024;
+
+    http::status status = http::status::ok;
+    std::string_view content_type;
+    std::string_view vary;
+    std::string body;
+    // арена текущего запроса, пуста вне with_session
+    boost::json::storage_ptr storage;
+    boost::json::serializer serializer;
+    alignas(std::max_align_t) unsigned char arena[ARENA_SIZE];
+
+    void write_json(const boost::json::object& data) {
+        serializer.reset(&data);
+        body.clear();
+        char chunk[4096];
+        while (!serializer.done()) {
+            auto part = serializer.read(chunk, sizeof(chunk));
+            body.append(part.data(), part.size());
+        }
+    }
+};
+
 class http_connection : public std::enable_shared_from_this<http_connection> {
     beast::tcp_stream stream_;
     beast::flat_buffer buffer_;
     http::request<http::string_body> req_;
-    std::shared_ptr<void> res_;
-    Game& game_;
-    CommandProcessor& processor_;
+    // заголовок и тело ответа живут в соединении до конца записи
+    std::string head_;
+    api_reply reply_;
+    // разбор тела POST и команда из него
+    boost::json::parser parser_;
+    std::string command_;
+    SessionManager& sessions_;
+    const AssetCache& assets_;
+    std::shared_ptr<Session> session_;
+    std::string session_id_;
+    bool session_created_ = false;
     std::string client_address_;
+    // буфер для /changes, переиспользуется между запросами соединения
+    std::vector<CellChange> changes_;
+    // маршрут текущего запроса для гистограммы; время считается до отправки ответа
+    std::optional<Histogram> route_;
+    std::chrono::steady_clock::time_point request_start_;
 
 public:
-    http_connection(tcp::socket&& socket, Game& game, CommandProcessor& processor)
+    http_connection(tcp::socket&& socket, SessionManager& sessions, const AssetCache& assets)
         : stream_(std::move(socket))
-        , game_(game)
-        , processor_(processor) {
+        , sessions_(sessions)
+        , assets_(assets) {
             client_address_ = stream_.socket().remote_endpoint().address().to_string() + 
                             ":" + std::to_string(stream_.socket().remote_endpoint().port());
-            std::cout << "New connection from " << client_address_ << std::endl;
+            LOG_DEBUG("New connection from ", client_address_);
         }
 
     void start() {
-        std::cout << "Starting connection handling for " << client_address_ << std::endl;
+        LOG_DEBUG("Starting connection handling for ", client_address_);
         read_request();
     }
 
@@ -53,12 +336,11 @@ private:
             req_,
             [self](beast::error_code ec, std::size_t bytes_transferred) {
                 if(ec == http::error::end_of_stream) {
-                    std::cout << "Client closed connection: " << self->client_address_ << std::endl;
+                    LOG_DEBUG("Client closed connection: ", self->client_address_);
                     return self->do_close();
                 }
                 if(ec) {
-                    std::cerr << "Error reading request from " << self->client_address_ 
-                             << ": " << ec.message() << std::endl;
+                    LOG_WARN("Error reading request from ", self->client_address_, ": ", ec.message());
                     return;
                 }
                 self->handle_request();
@@ -69,111 +351,204 @@ private:
         beast::error_code ec;
         stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
         if(ec) {
-            std::cerr << "Error closing connection for " << client_address_ 
-                     << ": " << ec.message() << std::endl;
+            LOG_WARN("Error closing connection for ", client_address_, ": ", ec.message());
         }
     }
 
-    bool ends_with(const std::string& str, const std::string& suffix) {
-        if (str.length() < suffix.length()) return false;
-        return str.compare(str.length() - suffix.length(), suffix.length(), suffix) == 0;
+    std::string read_session_id() const {
+        auto header = req_[SESSION_HEADER];
+        if (!header.empty()) return std::string(header);
+
+        auto cookie = req_[http::field::cookie];
+        std::string_view cookies(cookie.data(), cookie.size());
+        while (!cookies.empty()) {
+            size_t end = cookies.find(';');
+            std::string_view pair = cookies.substr(0, end);
+            while (!pair.empty() && pair.front() == ' ') pair.remove_prefix(1);
+            if (pair.size() > SESSION_COOKIE.size() && pair.compare(0, SESSION_COOKIE.size(), SESSION_COOKIE) == 0 &&
+                pair[SESSION_COOKIE.size()] == '=') {
+                return std::string(pair.substr(SESSION_COOKIE.size() + 1));
+            }
+            if (end == std::string_view::npos) break;
+            cookies.remove_prefix(end + 1);
+        }
+        return {};
     }
 
-    std::string get_mime_type(const std::string& path) {
-        if (ends_with(path, ".html")) return "text/html";
-        if (ends_with(path, ".css")) return "text/css";
-        if (ends_with(path, ".js")) return "application/javascript";
-        return "application/octet-stream";
+    // сессия текущего запроса; неизвестный или пустой id заводит новую партию
+    Session& resolve_session() {
+        session_id_ = read_session_id();
+        session_ = sessions_.acquire(session_id_, session_created_);
+        if (session_created_) {
+            LOG_INFO("New session ", session_id_, " for ", client_address_, ", active sessions: ", sessions_.size());
+        }
+        return *session_;
     }
 
-    void send_file(const std::string& path) {
-        std::cout << "\nSending file request from " << client_address_ << std::endl;
-        std::cout << "Trying to send file: " << path << std::endl;
-        
-        try {
-            std::filesystem::path abs_path = std::filesystem::absolute(path);
-            std::cout << "Absolute path: " << abs_path.string() << std::endl;
-            
-            if (!std::filesystem::exists(abs_path)) {
-                std::cerr << "File does not exist: " << abs_path.string() << std::endl;
-                return send_bad_response(http::status::not_found, "File not found");
-            }
-            
-            if (!std::filesystem::is_regular_file(abs_path)) {
-                std::cerr << "Not a regular file: " << abs_path.string() << std::endl;
-                return send_bad_response(http::status::not_found, "Not a regular file");
-            }
-            
-            auto file_size = std::filesystem::file_size(abs_path);
-            std::cout << "File size: " << file_size << " bytes" << std::endl;
-            
-            std::ifstream file(abs_path, std::ios::binary);
-            if (!file) {
-                std::cerr << "Failed to open file: " << abs_path.string() << std::endl;
-                return send_bad_response(http::status::internal_server_error, "Failed to open file");
-            }
-            
-            auto res = std::make_shared<http::response<http::string_body>>();
-            res->version(req_.version());
-            res->result(http::status::ok);
-            res->set(http::field::server, BOOST_BEAST_VERSION_STRING);
-            res->set(http::field::content_type, get_mime_type(path));
-            
-            res->set(http::field::cache_control, "no-store, no-cache, must-revalidate, max-age=0");
-            res->set(http::field::pragma, "no-cache");
-            res->set(http::field::expires, "0");
-            
-            res->set(http::field::access_control_allow_origin, "*");
-            res->set(http::field::access_control_allow_methods, "GET, POST, OPTIONS");
-            res->set(http::field::access_control_allow_headers, "Content-Type");
-            
-            bool keep_alive = req_.keep_alive();
-            res->keep_alive(keep_alive);
-            
-            std::stringstream buffer;
-            buffer << file.rdbuf();
-            std::string content = buffer.str();
-            
-            if (file.fail()) {
-                std::cerr << "Failed to read file: " << abs_path.string() << std::endl;
-                return send_bad_response(http::status::internal_server_error, "Failed to read file");
-            }
-            
-            file.close();
-            
-            res->body() = std::move(content);
-            res->prepare_payload();
-            
-            std::cout << "Prepared response:" << std::endl;
-            std::cout << "Status: " << res->result_int() << std::endl;
-            std::cout << "Headers:" << std::endl;
-            for(auto const& field : res->base()) {
-                std::cout << field.name_string() << ": " << field.value() << std::endl;
-            }
-            std::cout << "Body size: " << res->body().size() << " bytes" << std::endl;
-            
-            auto self = shared_from_this();
-            http::async_write(
-                stream_,
-                *res,
-                [self, res, keep_alive](beast::error_code ec, std::size_t bytes_transferred) {
-                    self->on_write(ec, bytes_transferred, !keep_alive);
-                });
-            
-        } catch (const std::exception& e) {
-            std::cerr << "Exception while sending file: " << e.what() << std::endl;
-            return send_bad_response(http::status::internal_server_error, e.what());
+    void add_session_headers(std::string& head) const {
+        if (!session_created_) return;
+        head += "Set-Cookie: " + SESSION_COOKIE + "=" + session_id_ + "; Path=/; HttpOnly; SameSite=Lax\r\n";
+        head += std::string(SESSION_HEADER) + ": " + session_id_ + "\r\n";
+    }
+
+    // строка статуса и заранее собранные поля; head_ сохраняет ёмкость между запросами
+    void begin_head(http::status status, std::string_view fields) {
+        head_.clear();
+        head_ += req_.version() == 10 ? "HTTP/1.0 " : "HTTP/1.1 ";
+        char code[8];
+        head_.append(code, std::to_chars(code, code + sizeof(code), static_cast<unsigned>(status)).ptr);
+        head_ += ' ';
+        auto reason = http::obsolete_reason(status);
+        head_.append(reason.data(), reason.size());
+        head_ += "\r\n";
+        head_ += fields;
+    }
+
+    void add_header(std::string_view name, std::string_view value) {
+        head_ += name;
+        head_ += ": ";
+        head_ += value;
+        head_ += "\r\n";
+    }
+
+    // завершает head_ и пишет его вместе с телом; body должно жить до конца записи
+    void write_response(http::status status, std::string_view body, bool close) {
+        if (status != http::status::no_content && status != http::status::not_modified) {
+            char length[24];
+            head_ += "Content-Length: ";
+            head_.append(length, std::to_chars(length, length + sizeof(length), body.size()).ptr);
+            head_ += "\r\n";
+        }
+        if (close && req_.version() >= 11) {
+            head_ += "Connection: close\r\n";
+        } else if (!close && req_.version() < 11) {
+            head_ += "Connection: keep-alive\r\n";
         }
+        head_ += "\r\n";
+
+        std::array<net::const_buffer, 2> buffers{net::buffer(head_), net::buffer(body.data(), body.size())};
+        auto self = shared_from_this();
+        net::async_write(
+            stream_,
+            buffers,
+            [self, close](beast::error_code ec, std::size_t bytes_transferred) {
+                self->on_write(ec, bytes_transferred, close);
+            });
+    }
+
+    // work выполняется на strand сессии: запросы к одной партии идут по порядку,
+    // к разным - параллельно. Ответ отправляется уже на strand соединения.
+    template <class Work>
+    void with_session(Work work) {
+        resolve_session();
+        auto self = shared_from_this();
+        auto session = session_;
+        net::post(session->strand, [self, session, work = std::move(work)]() mutable {
+            api_reply& reply = self->reply_;
+            reply.status = http::status::ok;
+            reply.content_type = "application/json";
+            reply.vary = {};
+            reply.body.clear();
+            {
+                boost::json::monotonic_resource arena(reply.arena, sizeof(reply.arena));
+                reply.storage = &arena;
+                try {
+                    work(*session, reply);
+                } catch (const std::exception& e) {
+                    LOG_ERROR("Error processing request: ", e.what());
+                    reply.status = http::status::internal_server_error;
+                    reply.content_type = "text/plain";
+                    reply.body = e.what();
+                }
+                reply.storage = {};
+            }
+            net::post(self->stream_.get_executor(), [self] { self->send_reply(); });
+        });
+    }
+
+    void send_reply() {
+        begin_head(reply_.status, API_FIELDS);
+        add_header("Content-Type", reply_.content_type);
+        if (!reply_.vary.empty()) add_header("Vary", reply_.vary);
+        add_session_headers(head_);
+        write_response(reply_.status, reply_.body, !req_.keep_alive());
+    }
+
+    // переводит соединение в поток SSE: ответ не завершается, а выстрелы
+    // и результаты команд партии дописываются в него по мере появления
+    void open_event_stream() {
+        resolve_session();
+        std::string header =
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Type: text/event-stream\r\n"
+            "Cache-Control: no-cache\r\n"
+            "Access-Control-Allow-Origin: *\r\n";
+        add_session_headers(header);
+        header += "\r\nretry: 2000\n\n";
+
+        LOG_DEBUG("Event stream opened for ", client_address_);
+        auto events = std::make_shared<event_stream>(std::move(stream_), session_);
+        events->start(std::move(header));
+
+        auto session = session_;
+        net::post(session->strand, [session, events] {
+            // наблюдатель хранится внутри партии, поэтому держит сессию по сырому указателю
+            Session* target = session.get();
+            session->game.setShotObserver([target](const ShotEvent& shot) {
+                if (target->hasSubscribers()) target->publish(make_shot_event(shot));
+            });
+            session->subscribe(events);
+        });
+    }
+
+    // счётчики и гистограммы в текстовом формате Prometheus
+    void send_metrics() {
+        reply_.body = Metrics::render();
+        reply_.body += "# TYPE sea_battle_sessions_active gauge\nsea_battle_sessions_active " +
+                       std::to_string(sessions_.size()) + "\n";
+        reply_.body += "# TYPE sea_battle_log_dropped_total counter\nsea_battle_log_dropped_total " +
+                       std::to_string(Logger::instance().dropped()) + "\n";
+        begin_head(http::status::ok, METRICS_FIELDS);
+        write_response(http::status::ok, reply_.body, !req_.keep_alive());
+    }
+
+    // клиент просит двоичный снимок вместо JSON
+    bool accepts_binary() const {
+        auto accept = req_[http::field::accept];
+        return accept.find("application/octet-stream") != decltype(accept)::npos;
+    }
+
+    // файл из кэша: тело не копируется, повторный запрос с тем же ETag получает 304
+    void send_asset(const Asset& asset) {
+        auto accept_encoding = req_[http::field::accept_encoding];
+        bool gzip = !asset.gzipBody.empty() &&
+                    accept_encoding.find("gzip") != decltype(accept_encoding)::npos;
+        const std::string& body = gzip ? asset.gzipBody : asset.body;
+        const std::string& etag = gzip ? asset.gzipEtag : asset.etag;
+
+        auto if_none_match = req_[http::field::if_none_match];
+        bool not_modified = if_none_match == "*" ||
+                            if_none_match.find(etag) != decltype(if_none_match)::npos;
+
+        http::status status = not_modified ? http::status::not_modified : http::status::ok;
+        begin_head(status, ASSET_FIELDS);
+        add_header("Content-Type", asset.contentType);
+        add_header("ETag", etag);
+        if (gzip) add_header("Content-Encoding", "gzip");
+        write_response(status, not_modified ? std::string_view() : std::string_view(body), !req_.keep_alive());
     }
 
     void on_write(beast::error_code ec, std::size_t bytes_transferred, bool close) {
+        if (route_) {
+            Metrics::observe(*route_, std::chrono::steady_clock::now() - request_start_);
+            route_.reset();
+        }
         if(ec) {
-            std::cerr << "Error writing response to " << client_address_ 
-                     << ": " << ec.message() << std::endl;
+            LOG_WARN("Error writing response to ", client_address_, ": ", ec.message());
             return;
         }
         
-        std::cout << "Successfully sent " << bytes_transferred << " bytes" << std::endl;
+        LOG_DEBUG("Successfully sent ", bytes_transferred, " bytes");
         
         if(close) {
             return do_close();
@@ -183,39 +558,17 @@ private:
         read_request();
     }
 
-    void send(http::response<http::string_body>&& res) {
-        auto self = shared_from_this();
-        
-        http::async_write(
-            stream_,
-            res,
-            [self](beast::error_code ec, std::size_t bytes_transferred) {
-                if(ec) {
-                    std::cerr << "Error writing response to " << self->client_address_ 
-                             << ": " << ec.message() << std::endl;
-                    return;
-                }
-                
-                if(self->req_.need_eof()) {
-                    self->do_close();
-                    return;
-                }
-                
-                self->buffer_.consume(self->buffer_.size());
-                self->read_request();
-            });
-    }
-
     void handle_request() {
-        std::cout << "\n=== New Request ===" << std::endl;
-        std::cout << "Method: " << req_.method_string() << std::endl;
-        std::cout << "Target: " << req_.target() << std::endl;
-        std::cout << "HTTP version: " << req_.version() << std::endl;
-        std::cout << "Headers:" << std::endl;
-        for(auto const& field : req_.base()) {
-            std::cout << field.name_string() << ": " << field.value() << std::endl;
+        request_start_ = std::chrono::steady_clock::now();
+        route_.reset();
+        LOG_DEBUG(client_address_, " ", req_.method_string(), " ", req_.target(), " HTTP/", req_.version() / 10, ".", req_.version() % 10);
+        if constexpr (SEA_BATTLE_MIN_LOG_LEVEL == 0) {
+            if (Logger::instance().enabled(LogLevel::DEBUG)) {
+                for(auto const& field : req_.base()) {
+                    LOG_DEBUG("  ", field.name_string(), ": ", field.value());
+                }
+            }
         }
-        std::cout << "==================" << std::endl;
         
         if (req_.method() == http::verb::options) {
             send_cors_headers(http::status::no_content);
@@ -223,88 +576,68 @@ private:
         }
 
         if (req_.method() == http::verb::get) {
-            std::string target = std::string(req_.target());
-            std::cout << "GET request for: " << target << std::endl;
+            std::string_view full_target(req_.target().data(), req_.target().size());
+            std::string target(full_target.substr(0, full_target.find('?')));
+            std::string_view query = target.size() < full_target.size() ? full_target.substr(target.size() + 1) : std::string_view();
             
-            std::filesystem::path base_path = std::filesystem::absolute("../web");
-            std::cout << "Base web directory: " << base_path.string() << std::endl;
-            
-            if (target == "/" || target == "/index.html") {
-                send_file((base_path / "index.html").string());
-            } else if (target == "/styles.css") {
-                send_file((base_path / "styles.css").string());
-            } else if (target == "/script.js") {
-                send_file((base_path / "script.js").string());
+            if (const Asset* asset = assets_.find(target)) {
+                route_ = Histogram::ROUTE_STATIC;
+                send_asset(*asset);
             } else if (target == "/ships") {
-                boost::json::object response;
-                boost::json::array ships_array;
-                
-                const auto& myShips = game_.getMyShips();
-                for(const auto& ship : myShips) {
-                    boost::json::object ship_obj;
-                    ship_obj["x"] = ship.getX();
-                    ship_obj["y"] = ship.getY();
-                    ship_obj["size"] = ship.getSize();
-                    ship_obj["horizontal"] = ship.isHorizontal();
-                    ships_array.push_back(ship_obj);
-                }
-                
-                response["ships"] = ships_array;
-                
-                auto res = std::make_shared<http::response<http::string_body>>();
-                res->version(req_.version());
-                res->result(http::status::ok);
-                res->set(http::field::server, BOOST_BEAST_VERSION_STRING);
-                res->set(http::field::content_type, "application/json");
-                res->set(http::field::access_control_allow_origin, "*");
-                res->set(http::field::access_control_allow_methods, "GET, POST, OPTIONS");
-                res->set(http::field::access_control_allow_headers, "Content-Type");
-                res->keep_alive(req_.keep_alive());
-                
-                res->body() = boost::json::serialize(response);
-                res->prepare_payload();
-
-                auto self = shared_from_this();
-                http::async_write(
-                    stream_,
-                    *res,
-                    [self, res, keep_alive = req_.keep_alive()](beast::error_code ec, std::size_t bytes_transferred) {
-                        if(ec) {
-                            std::cerr << "Error sending response: " << ec.message() << std::endl;
-                        }
-                        if (!keep_alive) {
-                            self->stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
-                        }
-                    });
+                route_ = Histogram::ROUTE_SHIPS;
+                with_session([](Session& session, api_reply& res) {
+                    boost::json::object response(res.storage);
+                    boost::json::array ships_array(res.storage);
+                    
+                    const auto& myShips = session.game.getMyShips();
+                    ships_array.reserve(myShips.size());
+                    for(const auto& ship : myShips) {
+                        boost::json::object ship_obj(res.storage);
+                        ship_obj["x"] = ship.getX();
+                        ship_obj["y"] = ship.getY();
+                        ship_obj["size"] = ship.getSize();
+                        ship_obj["horizontal"] = ship.isHorizontal();
+                        ships_array.push_back(std::move(ship_obj));
+                    }
+                    
+                    response["ships"] = std::move(ships_array);
+                    res.write_json(response);
+                });
             } else if (target == "/game-state") {
-                auto res = std::make_shared<http::response<http::string_body>>();
-                res->version(req_.version());
-                res->result(http::status::ok);
-                res->set(http::field::server, BOOST_BEAST_VERSION_STRING);
-                res->set(http::field::content_type, "application/json");
-                res->set(http::field::access_control_allow_origin, "*");
-                res->set(http::field::access_control_allow_methods, "GET, POST, OPTIONS");
-                res->set(http::field::access_control_allow_headers, "Content-Type");
-                res->keep_alive(req_.keep_alive());
-                
-                handle_get_game_state(req_, *res, game_);
-                
-                auto self = shared_from_this();
-                http::async_write(
-                    stream_,
-                    *res,
-                    [self, res, keep_alive = req_.keep_alive()](beast::error_code ec, std::size_t bytes_transferred) {
-                        if(ec) {
-                            std::cerr << "Error sending response: " << ec.message() << std::endl;
-                        }
-                        if (!keep_alive) {
-                            self->stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
-                        }
-                    });
+                route_ = Histogram::ROUTE_GAME_STATE;
+                with_session([this, binary = accepts_binary()](Session& session, api_reply& res) {
+                    res.vary = "Accept";
+                    if (binary) {
+                        res.content_type = "application/octet-stream";
+                        write_binary_snapshot(res.body, session.game);
+                    } else {
+                        handle_get_game_state(res, session.game);
+                    }
+                });
+            } else if (target == "/changes") {
+                route_ = Histogram::ROUTE_CHANGES;
+                std::string_view since_text = query_param(query, "since");
+                uint64_t since = 0;
+                auto parsed = std::from_chars(since_text.data(), since_text.data() + since_text.size(), since);
+                if (since_text.empty() || parsed.ec != std::errc() || parsed.ptr != since_text.data() + since_text.size()) {
+                    send_bad_response(http::status::bad_request, "Use /changes?since=<version>");
+                    return;
+                }
+                with_session([this, since](Session& session, api_reply& res) {
+                    handle_changes(session.game, since, res);
+                });
+            } else if (target == "/events") {
+                open_event_stream();
             } else if (target == "/shots") {
-                handle_shots();
+                route_ = Histogram::ROUTE_SHOTS;
+                with_session([this](Session& session, api_reply& res) {
+                    handle_shots(session.game, res);
+                });
+            } else if (target == "/metrics") {
+                route_ = Histogram::ROUTE_METRICS;
+                send_metrics();
             } else {
-                std::cout << "File not found: " << target << std::endl;
+                LOG_DEBUG("File not found: ", target);
                 send_bad_response(http::status::not_found, "File not found");
             }
             return;
@@ -315,288 +648,221 @@ private:
             return;
         }
 
-        try {
-            auto json = boost::json::parse(req_.body());
-            auto& obj = json.as_object();
-            std::string command = obj["command"].as_string().c_str();
-            
-            std::cout << "Processing command: " << command << std::endl;
-            std::string response = processor_.processCommand(command);
-            std::cout << "Command response: " << response << std::endl;
+        route_ = Histogram::ROUTE_COMMAND;
+        if (!parse_command()) {
+            LOG_WARN("Bad command request from ", client_address_);
+            send_bad_response(http::status::bad_request, "Expected {\"command\": \"...\"}");
+            return;
+        }
 
-            boost::json::object json_response;
+        LOG_DEBUG("Processing command: ", command_);
+        // command_ не меняется до отправки ответа: следующий запрос читается только после неё
+        with_session([this](Session& session, api_reply& res) {
+            std::string response;
+            {
+                MetricTimer timer(Metrics::commandHistogram(command_));
+                response = session.processor.processCommand(command_);
+            }
+            LOG_DEBUG("Command response: ", response);
+            if (session.hasSubscribers()) {
+                session.publish(make_state_event(command_, response, session.game));
+            }
+
+            boost::json::object json_response(res.storage);
             json_response["response"] = response;
-            
-            auto res = std::make_shared<http::response<http::string_body>>();
-            res->version(req_.version());
-            res->result(http::status::ok);
-            res->set(http::field::server, BOOST_BEAST_VERSION_STRING);
-            res->set(http::field::content_type, "application/json");
-            res->set(http::field::access_control_allow_origin, "*");
-            res->set(http::field::access_control_allow_methods, "GET, POST, OPTIONS");
-            res->set(http::field::access_control_allow_headers, "Content-Type");
-            res->keep_alive(req_.keep_alive());
-            
-            res->body() = boost::json::serialize(json_response);
-            res->prepare_payload();
-
-            auto self = shared_from_this();
-            http::async_write(
-                stream_,
-                *res,
-                [self, res, keep_alive = req_.keep_alive()](beast::error_code ec, std::size_t bytes_transferred) {
-                    if(ec) {
-                        std::cerr << "Error sending response: " << ec.message() << std::endl;
-                    }
-                    if (!keep_alive) {
-                        self->stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
-                    }
-                });
+            res.write_json(json_response);
+        });
+    }
+
+    // команда из тела {"command": "..."} в command_; разбор идёт в арене соединения
+    bool parse_command() {
+        boost::json::monotonic_resource arena(reply_.arena, sizeof(reply_.arena));
+        boost::system::error_code ec;
+        parser_.reset(&arena);
+        parser_.write(req_.body(), ec);
+        bool parsed = false;
+        if (!ec) {
+            boost::json::value json = parser_.release();
+            const boost::json::object* obj = json.if_object();
+            const boost::json::value* command = obj ? obj->if_contains("command") : nullptr;
+            if (command && command->is_string()) {
+                const boost::json::string& text = command->get_string();
+                command_.assign(text.data(), text.size());
+                parsed = true;
+            }
         }
-        catch(const std::exception& e) {
-            std::cerr << "Error processing request: " << e.what() << std::endl;
-            send_bad_response(http::status::bad_request, e.what());
+        // парсер не должен ссылаться на арену после её разрушения
+        parser_.reset();
+        return parsed;
+    }
+
+    void handle_get_game_state(api_reply& res, const Game& game) {
+        boost::json::object response(res.storage);
+        add_board_snapshot(response, game);
+        res.write_json(response);
+    }
+
+    // изменения после версии since; если журнал их уже не помнит, отдаётся полный снимок
+    void handle_changes(const Game& game, uint64_t since, api_reply& res) {
+        boost::json::object response(res.storage);
+        if (!game.getChangesSince(since, changes_)) {
+            response["full"] = true;
+            add_board_snapshot(response, game);
+            res.write_json(response);
+            return;
         }
+
+        boost::json::array changes(res.storage);
+        changes.reserve(changes_.size());
+        for (const auto& change : changes_) {
+            boost::json::object cell(res.storage);
+            cell["board"] = change.enemyBoard ? "enemy" : "my";
+            cell["x"] = change.x;
+            cell["y"] = change.y;
+            cell["state"] = static_cast<int>(change.state);
+            changes.push_back(std::move(cell));
+        }
+        response["full"] = false;
+        response["version"] = game.getVersion();
+        response["changes"] = std::move(changes);
+        add_game_over(response, game);
+        res.write_json(response);
     }
 
-    void handle_get_game_state(const http::request<http::string_body>& req,
-                          http::response<http::string_body>& res,
-                          Game& game) {
-        boost::json::object response;
-        
+    void add_board_snapshot(boost::json::object& response, const Game& game) {
         auto& myBoard = game.getPlayerBoard();
         auto& enemyBoard = game.getEnemyBoard();
         
-        boost::json::array myBoardJson;
-        boost::json::array enemyBoardJson;
-
-        for (size_t i = 0; i < myBoard.size(); ++i) {
-            boost::json::array row1, row2;
-            for (size_t j = 0; j < myBoard[i].size(); ++j) {
-                row1.push_back(static_cast<int>(myBoard[i][j]));
-                row2.push_back(static_cast<int>(enemyBoard[i][j]));
+        // массивы строятся в той же памяти, что и response, и переносятся в него без копий
+        const boost::json::storage_ptr& storage = response.storage();
+        boost::json::array myBoardJson(storage);
+        boost::json::array enemyBoardJson(storage);
+
+        // разреженное поле целиком не отдаём, выстрелы доступны через /shots
+        uint64_t rows = myBoard.isSparse() ? 0 : myBoard.getHeight();
+        myBoardJson.reserve(rows);
+        enemyBoardJson.reserve(rows);
+        for (uint64_t y = 0; y < rows; ++y) {
+            boost::json::array row1(storage), row2(storage);
+            row1.reserve(myBoard.getWidth());
+            row2.reserve(myBoard.getWidth());
+            for (uint64_t x = 0; x < myBoard.getWidth(); ++x) {
+                row1.push_back(static_cast<int>(myBoard.get(x, y)));
+                row2.push_back(static_cast<int>(enemyBoard.get(x, y)));
             }
-            myBoardJson.push_back(row1);
-            enemyBoardJson.push_back(row2);
+            myBoardJson.push_back(std::move(row1));
+            enemyBoardJson.push_back(std::move(row2));
         }
         
-        response["myBoard"] = myBoardJson;
-        response["enemyBoard"] = enemyBoardJson;
-        
-        res.body() = boost::json::serialize(response);
-        res.prepare_payload();
+        response["version"] = game.getVersion();
+        response["myBoard"] = std::move(myBoardJson);
+        response["enemyBoard"] = std::move(enemyBoardJson);
+        add_game_over(response, game);
     }
 
-    void handle_shots() {
-        boost::json::object response;
+    void handle_shots(const Game& game, api_reply& res) {
+        boost::json::object response(res.storage);
         
         // выстрелы
-        boost::json::array playerShots = boost::json::array();
-        boost::json::array enemyShots = boost::json::array();
+        boost::json::array playerShots(res.storage);
+        boost::json::array enemyShots(res.storage);
         
         // выстрелы с игрока
-        for (size_t y = 0; y < game_.getHeight(); ++y) {
-            for (size_t x = 0; x < game_.getWidth(); ++x) {
-                CellState state = game_.getPlayerBoard()[y][x];
-                if (state == CellState::HIT || state == CellState::MISS) {
-                    boost::json::object shot;
-                    shot["x"] = x;
-                    shot["y"] = y;
-                    shot["result"] = (state == CellState::HIT) ? "hit" : "miss";
-                    enemyShots.push_back(shot);
-                }
-            }
-        }
+        auto collectShots = [&res](const Board& board, boost::json::array& shots) {
+            board.forEach(CellState::HIT, [&](uint64_t x, uint64_t y) {
+                boost::json::object shot(res.storage);
+                shot["x"] = x;
+                shot["y"] = y;
+                shot["result"] = "hit";
+                shots.push_back(std::move(shot));
+            });
+            board.forEach(CellState::MISS, [&](uint64_t x, uint64_t y) {
+                boost::json::object shot(res.storage);
+                shot["x"] = x;
+                shot["y"] = y;
+                shot["result"] = "miss";
+                shots.push_back(std::move(shot));
+            });
+        };
+        collectShots(game.getPlayerBoard(), enemyShots);
         
         // выстрелы с противника
-        for (size_t y = 0; y < game_.getHeight(); ++y) {
-            for (size_t x = 0; x < game_.getWidth(); ++x) {
-                CellState state = game_.getEnemyBoard()[y][x];
-                if (state == CellState::HIT || state == CellState::MISS) {
-                    boost::json::object shot;
-                    shot["x"] = x;
-                    shot["y"] = y;
-                    shot["result"] = (state == CellState::HIT) ? "hit" : "miss";
-                    playerShots.push_back(shot);
-                }
-            }
-        }
-        
-        response["playerShots"] = playerShots;
-        response["enemyShots"] = enemyShots;
+        collectShots(game.getEnemyBoard(), playerShots);
         
-        auto res = std::make_shared<http::response<http::string_body>>();
-        res->version(req_.version());
-        res->result(http::status::ok);
-        res->set(http::field::server, BOOST_BEAST_VERSION_STRING);
-        res->set(http::field::content_type, "application/json");
-        res->set(http::field::access_control_allow_origin, "*");
-        res->set(http::field::access_control_allow_methods, "GET, POST, OPTIONS");
-        res->set(http::field::access_control_allow_headers, "Content-Type");
-        res->keep_alive(req_.keep_alive());
+        response["playerShots"] = std::move(playerShots);
+        response["enemyShots"] = std::move(enemyShots);
         
-        res->body() = boost::json::serialize(response);
-        res->prepare_payload();
-
-        auto self = shared_from_this();
-        http::async_write(
-            stream_,
-            *res,
-            [self, res, keep_alive = req_.keep_alive()](beast::error_code ec, std::size_t bytes_transferred) {
-                if(ec) {
-                    std::cerr << "Error sending response: " << ec.message() << std::endl;
-                }
-                if (!keep_alive) {
-                    self->stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
-                }
-            });
-    }
-
-    void send_response(const std::string& response) {
-        auto self = shared_from_this();
-
-        boost::json::object obj;
-        obj["response"] = response;
-        std::string body = boost::json::serialize(obj);
-
-        http::response<http::string_body> res{http::status::ok, req_.version()};
-        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-        res.set(http::field::content_type, "application/json");
-        res.set(http::field::access_control_allow_origin, "*");
-        res.set(http::field::access_control_allow_methods, "POST, OPTIONS");
-        res.set(http::field::access_control_allow_headers, "Content-Type");
-
-        bool keep_alive = req_.keep_alive();
-        if (keep_alive) {
-            res.set(http::field::connection, "keep-alive");
-            res.keep_alive(true);
-        } else {
-            res.set(http::field::connection, "close");
-        }
-
-        res.body() = body;
-        res.prepare_payload();
-
-        http::async_write(
-            stream_,
-            res,
-            [self, keep_alive](beast::error_code ec, std::size_t bytes_transferred) {
-                if(ec) {
-                    std::cerr << "Error sending response: " << ec.message() << std::endl;
-                }
-                if (!keep_alive) {
-                    self->stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
-                }
-            });
+        res.write_json(response);
     }
 
+    // ответ на предварительный запрос CORS
     void send_cors_headers(http::status status) {
-        auto self = shared_from_this();
-
-        http::response<http::empty_body> res{status, req_.version()};
-        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-        res.set(http::field::access_control_allow_origin, "*");
-        res.set(http::field::access_control_allow_methods, "POST, OPTIONS");
-        res.set(http::field::access_control_allow_headers, "Content-Type");
-
-        bool keep_alive = req_.keep_alive();
-        if (keep_alive) {
-            res.set(http::field::connection, "keep-alive");
-            res.keep_alive(true);
-        } else {
-            res.set(http::field::connection, "close");
-        }
-
-        res.prepare_payload();
-
-        http::async_write(
-            stream_,
-            res,
-            [self, keep_alive](beast::error_code ec, std::size_t bytes_transferred) {
-                if(ec) {
-                    std::cerr << "Error sending CORS headers: " << ec.message() << std::endl;
-                }
-                if (!keep_alive) {
-                    self->stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
-                }
-            });
+        begin_head(status, API_FIELDS);
+        write_response(status, {}, !req_.keep_alive());
     }
 
-    void send_bad_response(http::status status, const std::string& error) {
-        auto res = std::make_shared<http::response<http::string_body>>();
-        res->version(req_.version());
-        res->result(status);
-        res->set(http::field::server, BOOST_BEAST_VERSION_STRING);
-        res->set(http::field::content_type, "text/plain");
-        res->set(http::field::cache_control, "no-store, no-cache, must-revalidate, max-age=0");
-        res->set(http::field::pragma, "no-cache");
-        res->keep_alive(req_.keep_alive());
-        res->body() = error;
-        res->prepare_payload();
-
-        auto self = shared_from_this();
-        http::async_write(
-            stream_,
-            *res,
-            [self, res](beast::error_code ec, std::size_t bytes_transferred) {
-                self->on_write(ec, bytes_transferred, true);
-            });
+    void send_bad_response(http::status status, std::string_view error) {
+        reply_.body.assign(error.data(), error.size());
+        begin_head(status, ERROR_FIELDS);
+        write_response(status, reply_.body, true);
     }
 };
 
 class listener : public std::enable_shared_from_this<listener> {
     net::io_context& ioc_;
     tcp::acceptor acceptor_;
-    Game& game_;
-    CommandProcessor& processor_;
+    SessionManager& sessions_;
+    const AssetCache& assets_;
 
 public:
     listener(
         net::io_context& ioc,
         tcp::endpoint endpoint,
-        Game& game,
-        CommandProcessor& processor)
+        SessionManager& sessions,
+        const AssetCache& assets)
         : ioc_(ioc)
         , acceptor_(ioc)
-        , game_(game)
-        , processor_(processor)
+        , sessions_(sessions)
+        , assets_(assets)
     {
         beast::error_code ec;
 
         acceptor_.open(endpoint.protocol(), ec);
         if(ec) {
-            std::cerr << "open: " << ec.message() << std::endl;
+            LOG_ERROR("open: ", ec.message());
             return;
         }
 
         acceptor_.set_option(net::socket_base::reuse_address(true), ec);
         if(ec) {
-            std::cerr << "set_option: " << ec.message() << std::endl;
+            LOG_ERROR("set_option: ", ec.message());
             return;
         }
 
         acceptor_.bind(endpoint, ec);
         if(ec) {
-            std::cerr << "bind: " << ec.message() << std::endl;
+            LOG_ERROR("bind: ", ec.message());
             return;
         }
 
         acceptor_.listen(net::socket_base::max_listen_connections, ec);
         if(ec) {
-            std::cerr << "listen: " << ec.message() << std::endl;
+            LOG_ERROR("listen: ", ec.message());
             return;
         }
     }
 
     void run() {
-        std::cout << "Starting to accept connections..." << std::endl;
+        LOG_INFO("Starting to accept connections...");
         do_accept();
     }
 
 private:
     void do_accept() {
+        // у каждого соединения свой strand: его обработчики не пересекаются,
+        // а разные соединения обслуживаются потоками пула параллельно
         acceptor_.async_accept(
-            ioc_,
+            net::make_strand(ioc_),
             beast::bind_front_handler(
                 &listener::on_accept,
                 shared_from_this()));
@@ -604,45 +870,82 @@ private:
 
     void on_accept(beast::error_code ec, tcp::socket socket) {
         if(ec) {
-            std::cerr << "accept: " << ec.message() << std::endl;
+            LOG_ERROR("accept: ", ec.message());
         }
         else {
-            std::cout << "Accepted new connection" << std::endl;
+            LOG_DEBUG("Accepted new connection");
             std::make_shared<http_connection>(
                 std::move(socket),
-                game_,
-                processor_)->start();
+                sessions_,
+                assets_)->start();
         }
 
         do_accept();
     }
 };
 
-int main() {
+// периодически удаляет сессии, к которым не обращались дольше ttl
+void schedule_session_expiry(net::steady_timer& timer, SessionManager& sessions, std::chrono::seconds ttl) {
+    timer.expires_after(std::min(ttl, std::chrono::seconds(60)));
+    timer.async_wait([&timer, &sessions, ttl](beast::error_code ec) {
+        if (ec) return;
+        size_t removed = sessions.expire(ttl);
+        if (removed) {
+            LOG_INFO("Expired ", removed, " idle sessions, active: ", sessions.size());
+        }
+        schedule_session_expiry(timer, sessions, ttl);
+    });
+}
+
+int main(int argc, char* argv[]) {
     try {
+        // LOG_LEVEL=debug|info|warn|error; debug доступен только в отладочной сборке
+        LogLevel log_level;
+        if (const char* level = std::getenv("LOG_LEVEL"); level && Logger::parseLevel(level, log_level)) {
+            Logger::instance().setLevel(log_level);
+        }
+
         auto const address = net::ip::make_address("0.0.0.0");
-        auto const port = static_cast<unsigned short>(8080);
+        auto const port = static_cast<unsigned short>(argc > 1 ? std::stoul(argv[1]) : 8080);
+        auto const session_ttl = std::chrono::seconds(argc > 2 ? std::stoul(argv[2]) : 1800);
+        auto const threads = std::max<int>(1, argc > 3 ? std::stoi(argv[3]) : std::thread::hardware_concurrency());
         
-        net::io_context ioc{1};
+        net::io_context ioc{threads};
         
-        Game game;
-        CommandProcessor processor(game);
+        SessionManager sessions(ioc);
+
+        // файлы клиента читаются один раз; после правки web нужен перезапуск
+        auto const web_root = std::filesystem::absolute(argc > 4 ? argv[4] : "../web");
+        AssetCache assets;
+        size_t asset_count = assets.load(web_root);
+        LOG_INFO("Loaded ", asset_count, " web assets from ", web_root.string());
         
         std::make_shared<listener>(
             ioc,
             tcp::endpoint{address, port},
-            game,
-            processor)->run();
+            sessions,
+            assets)->run();
         
-        std::cout << "Server running on http://localhost:" << port << std::endl;
+        net::steady_timer expiry_timer(ioc);
+        schedule_session_expiry(expiry_timer, sessions, session_ttl);
         
+        LOG_INFO("Server running on http://localhost:", port, " with ", threads, " threads, idle sessions expire after ", session_ttl.count(), " s");
+        
+        std::vector<std::thread> pool;
+        pool.reserve(threads - 1);
+        for (int i = 1; i < threads; ++i) {
+            pool.emplace_back([&ioc] { ioc.run(); });
+        }
         ioc.run();
+        for (auto& thread : pool) {
+            thread.join();
+        }
         
-        std::cout << "Server stopped" << std::endl;
+        LOG_INFO("Server stopped");
         return EXIT_SUCCESS;
         
     } catch(std::exception const& e) {
-        std::cerr << "Error: " << e.what() << std::endl;
+        LOG_ERROR("Error: ", e.what());
         return EXIT_FAILURE;
     }
 }
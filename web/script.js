@@ -8,6 +8,8 @@ class Game {
         this.isGameOver = false;
         this.width = 10;
         this.height = 10;
+        // версия партии, до которой поля на странице актуальны
+        this.version = 0;
         
         this.createBoards();
         this.setupEventListeners();
@@ -16,19 +18,153 @@ class Game {
 
     async initializeGame() {
         try {
-            const response = await fetch('/game-state');
+            // двоичный снимок в десятки раз меньше JSON с массивами клеток
+            const response = await fetch('/game-state', {
+                headers: { 'Accept': 'application/octet-stream' },
+            });
             if (response.ok) {
-                const data = await response.json();
+                const data = this.decodeSnapshot(await response.arrayBuffer());
                 this.gameActive = true;
+                this.version = data.version;
                 this.updateBoard(this.playerBoard, data.myBoard, true);
                 this.updateBoard(this.enemyBoard, data.enemyBoard, false);
-                this.startUpdateInterval();
+                this.connectEvents();
             }
         } catch (error) {
             console.error('Error initializing game:', error);
         }
     }
 
+    // Формат описан у make_binary_snapshot в WebServer.cpp
+    decodeSnapshot(buffer) {
+        const view = new DataView(buffer);
+        const magic = String.fromCharCode(...new Uint8Array(buffer, 0, 4));
+        if (magic !== 'SBS1') {
+            throw new Error('Unknown snapshot format');
+        }
+        const version = Number(view.getBigUint64(4, true));
+        const width = Number(view.getBigUint64(12, true));
+        const height = Number(view.getBigUint64(20, true));
+        const flags = view.getUint8(28);
+        let offset = 29;
+
+        const readBoard = () => {
+            const rows = [];
+            if (flags & 4) return rows;
+            let row = [];
+            let remaining = width * height;
+            while (remaining > 0) {
+                const head = view.getUint8(offset++);
+                let length = (head >> 3) & 15;
+                if (head & 0x80) {
+                    let shift = 4;
+                    let byte;
+                    do {
+                        byte = view.getUint8(offset++);
+                        length += (byte & 0x7f) * 2 ** shift;
+                        shift += 7;
+                    } while (byte & 0x80);
+                }
+                length += 1;
+                remaining -= length;
+                const state = head & 7;
+                for (let i = 0; i < length; i++) {
+                    row.push(state);
+                    if (row.length === width) {
+                        rows.push(row);
+                        row = [];
+                    }
+                }
+            }
+            return rows;
+        };
+
+        const myBoard = readBoard();
+        const enemyBoard = readBoard();
+        return {
+            version,
+            myBoard,
+            enemyBoard,
+            gameOver: (flags & 1) !== 0,
+            winner: (flags & 2) ? 'player' : 'enemy',
+        };
+    }
+
+    // Сервер сам присылает каждый выстрел и результат команды, опрос нужен
+    // только браузерам без EventSource
+    connectEvents() {
+        if (!window.EventSource) {
+            this.startUpdateInterval();
+            return;
+        }
+        this.events = new EventSource('/events');
+        // после переподключения пропущенные события восполняет полный снимок
+        this.events.addEventListener('open', () => this.updateGameState());
+        this.events.addEventListener('shot', (event) => this.applyShot(JSON.parse(event.data)));
+        this.events.addEventListener('state', (event) => this.applyState(JSON.parse(event.data)));
+    }
+
+    applyShot(shot) {
+        this.version = Math.max(this.version, shot.version);
+        const board = shot.shooter === 'player' ? this.enemyBoard : this.playerBoard;
+        if (shot.result === 'kill' && shot.ship) {
+            const ship = shot.ship;
+            const endX = ship.horizontal ? ship.x + ship.size - 1 : ship.x;
+            const endY = ship.horizontal ? ship.y : ship.y + ship.size - 1;
+            for (let y = ship.y - 1; y <= endY + 1; y++) {
+                for (let x = ship.x - 1; x <= endX + 1; x++) {
+                    const cell = board.querySelector(`.grid .cell[data-x="${x}"][data-y="${y}"]`);
+                    if (!cell) continue;
+                    if (x >= ship.x && x <= endX && y >= ship.y && y <= endY) {
+                        cell.classList.remove('ship', 'hit');
+                        cell.classList.add('destroyed');
+                    } else if (!cell.classList.contains('destroyed')) {
+                        cell.classList.add('miss');
+                    }
+                }
+            }
+            return;
+        }
+        const cell = board.querySelector(`.grid .cell[data-x="${shot.x}"][data-y="${shot.y}"]`);
+        if (cell) {
+            cell.classList.remove('ship');
+            cell.classList.add(shot.result === 'miss' ? 'miss' : 'hit');
+        }
+    }
+
+    async applyState(state) {
+        // выстрелы уже пришли отдельными событиями, остальные команды
+        // (start, load, set size ...) могут перестроить поля целиком
+        if (!state.command.startsWith('shot')) {
+            await this.updateGameState();
+        }
+        if (state.gameOver) {
+            await this.finishGame(state.winner);
+        }
+    }
+
+    async finishGame(winner) {
+        if (this.isGameOver) return;
+        await new Promise(resolve => setTimeout(resolve, 1000));
+        if (this.isGameOver) return;
+
+        this.isGameOver = true;
+        this.gameActive = false;
+
+        const gameResult = document.getElementById('gameResult');
+        if (winner === 'player') {
+            gameResult.textContent = 'You Won!';
+            gameResult.className = 'game-result win';
+            this.appendToConsole('Game Over - You Won!');
+        } else {
+            gameResult.textContent = 'You Lost!';
+            gameResult.className = 'game-result lose';
+            this.appendToConsole('Game Over - You Lost!');
+        }
+
+        this.stopUpdateInterval();
+    }
+
     startUpdateInterval() {
         if (this.updateInterval) {
             clearInterval(this.updateInterval);
@@ -47,34 +183,30 @@ class Game {
         if (this.isGameOver) return;
 
         try {
-            const response = await fetch('/game-state');
+            // сервер отдаёт только клетки, изменившиеся с нашей версии,
+            // или полный снимок, если поля с тех пор перестраивались
+            const response = await fetch(`/changes?since=${this.version}`);
             if (!response.ok) {
                 throw new Error('Network response was not ok');
             }
 
             const data = await response.json();
-            
-            this.updateBoard(this.playerBoard, data.myBoard, true);
-            this.updateBoard(this.enemyBoard, data.enemyBoard, false);
-
-            if (data.gameOver && !this.isGameOver) {
-                await new Promise(resolve => setTimeout(resolve, 1000));
-
-                this.isGameOver = true;
-                this.gameActive = false;
 
-                const gameResult = document.getElementById('gameResult');
-                if (data.winner === 'player') {
-                    gameResult.textContent = 'You Won!';
-                    gameResult.className = 'game-result win';
-                    this.appendToConsole('Game Over - You Won!');
-                } else {
-                    gameResult.textContent = 'You Lost!';
-                    gameResult.className = 'game-result lose';
-                    this.appendToConsole('Game Over - You Lost!');
-                }
+            if (data.full) {
+                this.updateBoard(this.playerBoard, data.myBoard, true);
+                this.updateBoard(this.enemyBoard, data.enemyBoard, false);
+            } else {
+                data.changes.forEach(change => {
+                    const isPlayerBoard = change.board === 'my';
+                    const board = isPlayerBoard ? this.playerBoard : this.enemyBoard;
+                    const cell = board.querySelector(`.grid .cell[data-x="${change.x}"][data-y="${change.y}"]`);
+                    if (cell) this.renderCell(cell, change.state, isPlayerBoard);
+                });
+            }
+            this.version = data.version;
 
-                this.stopUpdateInterval();
+            if (data.gameOver) {
+                await this.finishGame(data.winner);
             }
         } catch (error) {
             console.error('Error updating game state:', error);
@@ -107,36 +239,9 @@ class Game {
                 this.appendToConsole(result.response);
             }
 
-            await new Promise(resolve => setTimeout(resolve, 300));
-            
-            const stateResponse = await fetch('/game-state');
-            if (!stateResponse.ok) {
-                throw new Error('Network response was not ok');
-            }
-
-            const gameState = await stateResponse.json();
-
-            this.updateBoard(this.playerBoard, gameState.myBoard, true);
-            this.updateBoard(this.enemyBoard, gameState.enemyBoard, false);
-
-            if (gameState.gameOver && !this.isGameOver) {
-                await new Promise(resolve => setTimeout(resolve, 1000));
-
-                this.isGameOver = true;
-                this.gameActive = false;
-
-                const gameResult = document.getElementById('gameResult');
-                if (gameState.winner === 'player') {
-                    gameResult.textContent = 'You Won!';
-                    gameResult.className = 'game-result win';
-                    this.appendToConsole('Game Over - You Won!');
-                } else {
-                    gameResult.textContent = 'You Lost!';
-                    gameResult.className = 'game-result lose';
-                    this.appendToConsole('Game Over - You Lost!');
-                }
-
-                this.stopUpdateInterval();
+            // поля обновят события выстрелов
+            if (!this.events) {
+                await this.updateGameState();
             }
         } catch (error) {
             console.error('Error making shot:', error);
@@ -182,13 +287,18 @@ class Game {
 
             if (command === 'start') {
                 this.gameActive = true;
-                this.startUpdateInterval();
             } else if (command === 'stop') {
                 this.gameActive = false;
-                this.stopUpdateInterval();
             }
 
-            await this.updateGameState();
+            if (!this.events) {
+                if (command === 'start') {
+                    this.startUpdateInterval();
+                } else if (command === 'stop') {
+                    this.stopUpdateInterval();
+                }
+                await this.updateGameState();
+            }
             
             return result;
         } catch (error) {
@@ -278,24 +388,28 @@ class Game {
             row.forEach((cell, x) => {
                 const cellElement = board.querySelector(`.grid .cell[data-x="${x}"][data-y="${y}"]`);
                 if (cellElement) {
-                    cellElement.classList.remove('ship', 'hit', 'miss', 'destroyed', 'surrounding');
-                    
-                    if (cell === 1 && isPlayerBoard) { // SHIP
-                        cellElement.classList.add('ship');
-                    } else if (cell === 2) { // HIT
-                        cellElement.classList.add('hit');
-                    } else if (cell === 3) { // MISS
-                        cellElement.classList.add('miss');
-                    } else if (cell === 4) { // DESTROYED
-                        cellElement.classList.add('destroyed');
-                    } else if (cell === 5) { // SURROUNDING
-                        cellElement.classList.add('surrounding');
-                    }
+                    this.renderCell(cellElement, cell, isPlayerBoard);
                 }
             });
         });
     }
 
+    renderCell(cellElement, cell, isPlayerBoard) {
+        cellElement.classList.remove('ship', 'hit', 'miss', 'destroyed', 'surrounding');
+
+        if (cell === 1 && isPlayerBoard) { // SHIP
+            cellElement.classList.add('ship');
+        } else if (cell === 2) { // HIT
+            cellElement.classList.add('hit');
+        } else if (cell === 3) { // MISS
+            cellElement.classList.add('miss');
+        } else if (cell === 4) { // DESTROYED
+            cellElement.classList.add('destroyed');
+        } else if (cell === 5) { // SURROUNDING
+            cellElement.classList.add('surrounding');
+        }
+    }
+
     async sendCommand(command) {
         console.log('Sending command:', command);
         try {